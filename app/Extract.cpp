@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "Matcher.h"
+#include "Sweep.h"
 
 namespace po = boost::program_options;
 
@@ -30,7 +31,16 @@ int main(int argc, char *argv[]) {
         "image_path", po::value<string>(&image_path), "image path, end with %04d.jpg or png")(
         "project_path", po::value<string>(&project_path), "colmap project directory path");
 
+    bool create_database; // 自行新建数据库，不再依赖 colmap feature_extractor
+    string camera_model;
+    desc.add_options()("create_database", po::value<bool>(&create_database)->default_value(0),
+                       "create database.db with cameras and images instead of reading it.")(
+        "camera_model", po::value<string>(&camera_model)->default_value("OPENCV"),
+        "COLMAP camera model used by --create_database.");
+
     bool is_aruco; // 使用随机三维点 or 进行 ArUco 检测
+    bool projection_benchmark;
+    uint64_t seed;
     int max_points, pixel_error;
     vector<int> track_length;
     vector<int> axis_range;  // 依次为 XYZ 三个轴的范围
@@ -38,7 +48,69 @@ int main(int argc, char *argv[]) {
         "max_points", po::value<int>(&max_points), "Numbers of random 3D points.")(
         "pixel_error", po::value<int>(&pixel_error), "2D detection pixel error")(
         "track_length", po::value<vector<int>>(&track_length)->multitoken(), "3D point track length range")(
-        "axis_range", po::value<vector<int>>(&axis_range)->multitoken(), "3D point range");
+        "axis_range", po::value<vector<int>>(&axis_range)->multitoken(), "3D point range")(
+        "seed", po::value<uint64_t>(&seed), "random seed, a random one is printed if not given.")(
+        "projection_benchmark", po::value<bool>(&projection_benchmark)->default_value(0),
+        "compare per-point cv::Mat projection with the batched Eigen projection.");
+
+    MatchOptions match_options; // ArUco 检测流水线
+    desc.add_options()("io_threads", po::value<int>(&match_options.io_threads)->default_value(0),
+                       "image read/decode threads, 0 disables the pipeline.")(
+        "detect_threads", po::value<int>(&match_options.detect_threads)->default_value(0),
+        "pipeline detection threads, 0 uses all cores.")(
+        "queue_size", po::value<int>(&match_options.queue_size)->default_value(64),
+        "pipeline queue capacity in images.")(
+        "pyramid_level", po::value<int>(&match_options.pyramid_level)->default_value(0),
+        "detect markers on an image reduced by 2^level, 0 for full resolution.")(
+        "pyramid_report", po::value<bool>(&match_options.pyramid_report)->default_value(0),
+        "compare coarse-to-fine detection against full resolution.")(
+        "roi_tracking", po::value<bool>(&match_options.roi_tracking)->default_value(0),
+        "search near the board position of the previous group first.")(
+        "roi_padding", po::value<float>(&match_options.roi_padding)->default_value(0.5f),
+        "tracking ROI padding relative to the board size.")(
+        "video_path", po::value<string>(&match_options.video_path),
+        "one video per camera, end with %d.mp4; frame i is group i.")(
+        "detect_cache", po::value<string>(&match_options.cache_path),
+        "detection cache file, reruns only detect new or changed images.");
+
+    ExportOptions export_options;
+    bool ransac_check;
+    desc.add_options()("write_geometries",
+                       po::value<bool>(&export_options.write_geometries)->default_value(0),
+                       "write two_view_geometries directly instead of match.txt.")(
+        "verify", po::value<bool>(&export_options.verify)->default_value(0),
+        "verify each camera pair with RANSAC and keep only inliers.")(
+        "ransac_error",
+        po::value<double>(&export_options.verify_options.max_error)->default_value(4.0),
+        "RANSAC Sampson error threshold in pixels.")(
+        "min_inliers", po::value<int>(&export_options.verify_options.min_inliers)->default_value(15),
+        "minimum inliers for a verified camera pair.")(
+        "ransac_check", po::value<bool>(&ransac_check)->default_value(0),
+        "check on synthetic data with outliers that RANSAC recovers the true inliers, then exit.")(
+        "append", po::value<bool>(&export_options.append)->default_value(0),
+        "append the detected groups to the keypoints and matches already in the database.");
+
+    SweepOptions sweep_options; // 随机点实验的参数网格，一次运行生成多个数据库
+    desc.add_options()("sweep_pixel_error",
+                       po::value<vector<int>>(&sweep_options.pixel_errors)->multitoken(),
+                       "pixel_error values to sweep.")(
+        "sweep_track_length", po::value<vector<int>>(&sweep_options.track_lengths)->multitoken(),
+        "track_length ranges to sweep, given as min max pairs.")(
+        "sweep_max_points", po::value<vector<int>>(&sweep_options.max_points)->multitoken(),
+        "max_points values to sweep.")(
+        "sweep_jobs", po::value<int>(&sweep_options.jobs)->default_value(0),
+        "configurations run at the same time, 0 uses all cores.");
+    bool is_sweep(false);
+
+    string shard_path; // 只检测并写出本进程负责的组，由 Merge 合并
+    desc.add_options()("shard_path", po::value<string>(&shard_path),
+                       "write this group range's observations to a shard file and skip export.");
+
+    int stream_groups, stream_buffer_mb; // 分块检测、溢出到磁盘，内存与组数无关
+    desc.add_options()("stream_groups", po::value<int>(&stream_groups)->default_value(0),
+                       "detect and spill this many groups at a time, 0 keeps all in memory.")(
+        "stream_buffer_mb", po::value<int>(&stream_buffer_mb)->default_value(64),
+        "merge buffer size in MB for --stream_groups.");
 
     po::variables_map vm;
     po::store(po::parse_command_line(
@@ -51,34 +123,134 @@ int main(int argc, char *argv[]) {
         cout << desc << endl;
     }
 
+    if (ransac_check) {
+        bool ok(true);
+        for (double outlier_ratio : {0.3, 0.5}) {
+            for (int num_points : {200, 5000}) {
+                ok = CheckFundamentalRansac(export_options.verify_options, num_points,
+                                            outlier_ratio) && ok;
+            }
+        }
+        return ok ? 0 : -1;
+    }
+
     auto start_time = chrono::system_clock::now();
 
     std::unordered_map<std::string, int> id_map;
     std::unordered_map<int, std::string> name_map;
 
     Matcher *matcherObj = new Matcher;
+    matcherObj->m_options = match_options;
 
-    cout << "1. CreateIdMap.........." << endl;
     string database_path(project_path + "/database.db");
-    CreateIdMap(database_path, id_map, name_map);
+    if (create_database && !shard_path.empty()) {
+        cout << "error: 分片共用同一个数据库，请先单独新建，不能同时使用 --create_database" << endl;
+        delete matcherObj;
+        return -1;
+    }
+    if (create_database && export_options.append) {
+        cout << "error: --append 需要已有的数据库，不能同时使用 --create_database" << endl;
+        delete matcherObj;
+        return -1;
+    }
+    if (create_database) {
+        cout << "1. CreateDatabase.........." << endl;
+        if (!CreateDatabase(database_path, image_path, cam_num, cam_start, group_start,
+                            camera_model, id_map, name_map)) {
+            delete matcherObj;
+            return -1;
+        }
+    } else {
+        cout << "1. CreateIdMap.........." << endl;
+        CreateIdMap(database_path, id_map, name_map);
+    }
 
-    if (is_aruco) { // * Seq Calib
+    string txt_path(project_path + "/match.txt");
+    if (is_aruco && !shard_path.empty()) { // * Seq Calib，分片
+        cout << "2. Match(ArUco) shard................" << endl;
+        matcherObj->m_options.observations_path = shard_path;
+        matcherObj->Match(image_path, group_num, cam_num, id_map, cam_start, group_start);
+        matcherObj->SaveDetectionCache();
+    } else if (is_aruco && stream_groups > 0) { // * Seq Calib，流式导出
+        if (export_options.verify) {
+            cout << "warning: --stream_groups 不支持 --verify，跳过几何校验" << endl;
+        }
+        if (export_options.append) {
+            cout << "error: --stream_groups 不支持 --append" << endl;
+            delete matcherObj;
+            return -1;
+        }
+        StreamingExporter exporter(cam_num, project_path);
+        if (!exporter.Open()) {
+            delete matcherObj;
+            return -1;
+        }
+        matcherObj->m_options.observations_path.clear();
+        for (int offset = 0; offset < group_num; offset += stream_groups) {
+            int chunk_num = std::min(stream_groups, group_num - offset);
+            cout << "2. Match(ArUco) groups " << group_start + offset << " ~ "
+                 << group_start + offset + chunk_num - 1 << "................" << endl;
+            matcherObj->Match(image_path, chunk_num, cam_num, id_map, cam_start,
+                              group_start + offset);
+            exporter.AddChunk(matcherObj->m_match_data);
+        }
+        matcherObj->SaveDetectionCache();
+        matcherObj->m_match_data.Reset(cam_num);
+        cout << "3. StreamingExport...." << endl;
+        if (!exporter.WriteDatabase(database_path, txt_path, name_map,
+                                    export_options.write_geometries || export_options.verify,
+                                    export_options.proj_matrices,
+                                    (size_t)stream_buffer_mb << 20)) {
+            printf("error streaming export to %s\n", database_path.c_str());
+            delete matcherObj;
+            return -1;
+        }
+    } else if (is_aruco) { // * Seq Calib
         cout << "2. Match(ArUco)................" << endl;
         matcherObj->Match(image_path, group_num, cam_num, id_map, cam_start, group_start);
+        matcherObj->SaveDetectionCache();
     } else {
-        cout << "2. Match(Random Points)................" << endl;
         string xmlPath = "./xml_gt/%d.xml"; // 标定参数的真值
         vector<vector<int>> boxSize{{axis_range[0], axis_range[1]},
                                     {axis_range[2], axis_range[3]},
                                     {axis_range[4], axis_range[5]}};
         bool has_circle(0); // ! 自然特征分布实验
         bool is_track_exp(0); // ! 共视相机数量实验
-        matcherObj->generateRandomPoints(xmlPath, cam_num, max_points, boxSize, track_length,
-                                         pixel_error, has_circle, is_track_exp);
+        if (!vm.count("seed")) {
+            seed = std::random_device()();
+        }
+        cout << "seed: " << seed << endl;
+        matcherObj->LoadProjections(xmlPath, cam_num);
+        is_sweep = !sweep_options.pixel_errors.empty() || !sweep_options.track_lengths.empty() ||
+                   !sweep_options.max_points.empty();
+        if (is_sweep) {
+            cout << "2-3. Sweep(Random Points)................" << endl;
+            SweepConfig defaults;
+            defaults.pixel_error = pixel_error;
+            defaults.track_length = track_length;
+            defaults.max_points = max_points;
+            vector<SweepConfig> configs = ExpandSweepGrid(sweep_options, defaults);
+            if (configs.empty()) {
+                delete matcherObj;
+                return -1;
+            }
+            RunSweep(configs, sweep_options, *matcherObj, project_path, cam_num, boxSize,
+                     has_circle, is_track_exp, seed, name_map, export_options);
+        } else {
+            cout << "2. Match(Random Points)................" << endl;
+            matcherObj->generateRandomPoints(xmlPath, cam_num, max_points, boxSize, track_length,
+                                             pixel_error, has_circle, is_track_exp, seed);
+        }
+        if (projection_benchmark) {
+            BenchmarkProjection(matcherObj->m_proj, max_points);
+        }
+    }
+    if ((!is_aruco && !is_sweep) || (is_aruco && shard_path.empty() && stream_groups <= 0)) {
+        cout << "3. ExtractToDatabase...." << endl;
+        export_options.proj_matrices = matcherObj->m_proj;
+        ExtractToDatabase(cam_num, database_path, txt_path, matcherObj->m_match_data, name_map,
+                          export_options);
     }
-    cout << "3. ExtractToDatabase...." << endl;
-    string txt_path(project_path + "/match.txt");
-    ExtractToDatabase(cam_num, database_path, txt_path, matcherObj->m_match_data, name_map);
 
     delete matcherObj;
 
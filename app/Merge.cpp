@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Matcher.h"
+
+namespace po = boost::program_options;
+
+// 合并多个 Extract --shard_path 写出的观测文件，按轨迹编号顺序导出到同一个数据库
+int main(int argc, char *argv[]) {
+    string project_path, image_path, camera_model;
+    vector<string> shard_paths;
+    int cam_num, cam_start, group_start, buffer_mb;
+    bool create_database, write_geometries;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()("help,h", "produce help message")(
+        "shards", po::value<vector<string>>(&shard_paths)->multitoken(),
+        "observation files written by Extract --shard_path.")(
+        "project_path", po::value<string>(&project_path), "colmap project directory path")(
+        "cam_num", po::value<int>(&cam_num)->required(), "camera numbers.")(
+        "cam_start", po::value<int>(&cam_start)->default_value(0), "camera index start.")(
+        "group_start", po::value<int>(&group_start)->default_value(0),
+        "group used to read image sizes for --create_database.")(
+        "image_path", po::value<string>(&image_path), "image path, end with %04d.jpg or png")(
+        "create_database", po::value<bool>(&create_database)->default_value(0),
+        "create database.db with cameras and images instead of reading it.")(
+        "camera_model", po::value<string>(&camera_model)->default_value("OPENCV"),
+        "COLMAP camera model used by --create_database.")(
+        "write_geometries", po::value<bool>(&write_geometries)->default_value(0),
+        "write two_view_geometries directly instead of match.txt.")(
+        "buffer_mb", po::value<int>(&buffer_mb)->default_value(64), "merge buffer size in MB.");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(
+                  argc, argv, desc,
+                  po::command_line_style::unix_style ^ po::command_line_style::allow_short),
+              vm);
+
+    if (vm.count("help") || shard_paths.empty()) {
+        cout << desc << endl;
+        return 0;
+    }
+    po::notify(vm);
+
+    auto start_time = chrono::steady_clock::now();
+
+    // 1. 读取各分片的文件头，按第一条轨迹的全局编号排序并检查是否重叠
+    cout << "1. ReadShards.........." << endl;
+    vector<std::pair<uint64_t, string>> shards;
+    for (const string &path : shard_paths) {
+        ObservationFile file;
+        uint64_t num_observations(0);
+        if (!ReadObservationHeader(path, file, num_observations)) {
+            printf("error read shard %s\n", path.c_str());
+            return -1;
+        }
+        if (file.cam_num != cam_num) {
+            printf("error shard %s has %u cameras, expected %d\n", path.c_str(), file.cam_num,
+                   cam_num);
+            return -1;
+        }
+        shards.push_back({file.track_offset, path});
+        printf("分片 %s: 轨迹 %lu ~ %lu, 观测 %lu\n", path.c_str(),
+               (unsigned long)file.track_offset,
+               (unsigned long)(file.track_offset + file.num_tracks),
+               (unsigned long)num_observations);
+    }
+    std::sort(shards.begin(), shards.end());
+
+    std::unordered_map<std::string, int> id_map;
+    std::unordered_map<int, std::string> name_map;
+    string database_path(project_path + "/database.db");
+    if (create_database) {
+        cout << "2. CreateDatabase.........." << endl;
+        if (!CreateDatabase(database_path, image_path, cam_num, cam_start, group_start,
+                            camera_model, id_map, name_map)) {
+            return -1;
+        }
+    } else {
+        cout << "2. CreateIdMap.........." << endl;
+        CreateIdMap(database_path, id_map, name_map);
+    }
+
+    // 3. 分片依次送入流式导出，特征点 id 与单进程处理全部组时一致
+    cout << "3. MergeShards...." << endl;
+    StreamingExporter exporter(cam_num, project_path);
+    if (!exporter.Open()) {
+        return -1;
+    }
+    uint64_t next_track(shards.front().first);
+    TrackStore tracks;
+    for (const auto &shard : shards) {
+        ObservationFile file;
+        if (!ReadObservations(shard.second, file)) {
+            printf("error read shard %s\n", shard.second.c_str());
+            return -1;
+        }
+        if (file.track_offset < next_track) {
+            printf("error shard %s overlaps the previous shard\n", shard.second.c_str());
+            return -1;
+        }
+        if (file.track_offset > next_track) {
+            printf("warning: 轨迹 %lu ~ %lu 没有对应的分片\n", (unsigned long)next_track,
+                   (unsigned long)file.track_offset);
+        }
+        next_track = file.track_offset + file.num_tracks;
+        tracks.Reset(cam_num);
+        AppendTracks(file, tracks);
+        exporter.AddChunk(tracks);
+    }
+    tracks.Reset(cam_num);
+    if (!exporter.WriteDatabase(database_path, project_path + "/match.txt", name_map,
+                                write_geometries, ProjectionList(), (size_t)buffer_mb << 20)) {
+        printf("error merge shards into %s\n", database_path.c_str());
+        return -1;
+    }
+
+    cout << "程序运行时间："
+         << chrono::duration<double>(chrono::steady_clock::now() - start_time).count() << " 秒."
+         << endl;
+    return 0;
+}
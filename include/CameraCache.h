@@ -0,0 +1,65 @@
+#ifndef _CAMERA_CACHE_H_
+#define _CAMERA_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 一个相机的真值参数，以及生成时对应 xml 文件的大小和修改时间
+struct CameraRecord
+{
+    int64_t xml_size;
+    int64_t xml_mtime_sec;
+    int64_t xml_mtime_nsec;
+    double P[12];  // 3x4 投影矩阵，行优先
+    int32_t width;  // 图像尺寸，决定随机点实验中的可见范围
+    int32_t height;
+};
+
+/**
+ * @brief xml_gt 真值相机的二进制缓存
+ *
+ * 第一次运行时由 xml 解析得到的参数写成定长记录的二进制文件，之后直接 mmap，
+ * 不再逐个用 cv::FileStorage 解析 xml。任一 xml 的大小或修改时间变化、相机数不同时缓存失效。
+ *
+ * 文件布局（小端）：
+ *   char[4]  magic "SQCM"
+ *   uint32   version
+ *   uint32   cam_num
+ *   uint32   reserved
+ *   CameraRecord[cam_num]
+ */
+class CameraCache
+{
+public:
+    CameraCache() : m_data(nullptr), m_size(0), m_records(nullptr), m_num_cameras(0) {}
+    ~CameraCache();
+
+    // 映射缓存文件并逐个核对 xml_paths 的大小和修改时间，不一致时返回 false
+    bool Load(const std::string &path, const std::vector<std::string> &xml_paths);
+
+    // 写临时文件再改名
+    static bool Save(const std::string &path, const std::vector<CameraRecord> &records);
+
+    // 用 xml 文件当前的大小和修改时间填写 record，文件不存在时返回 false
+    static bool StatXml(const std::string &xml_path, CameraRecord &record);
+
+    int NumCameras() const {
+        return m_num_cameras;
+    }
+
+    const CameraRecord &operator[](int cam_id) const {
+        return m_records[cam_id];
+    }
+
+private:
+    void Unmap();
+
+    void *m_data;
+    size_t m_size;
+    const CameraRecord *m_records;
+    int m_num_cameras;
+};
+
+#endif
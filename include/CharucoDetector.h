@@ -0,0 +1,77 @@
+#ifndef _CHARUCO_DETECTOR_H_
+#define _CHARUCO_DETECTOR_H_
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <opencv2/aruco.hpp>
+#include <opencv2/aruco/charuco.hpp>
+
+// ChArUco 标定板规格 ! 根据 ArUco 码的实际尺寸进行修改
+struct CharucoBoardSpec
+{
+    int squares_x = 10;
+    int squares_y = 10;
+    float square_length = 0.1f;
+    float marker_length = 0.078f;
+    int dictionary = cv::aruco::DICT_7X7_50;
+
+    // 棋盘格内角点数量，即每组图像最多能提供的特征点数
+    int NumCorners() const {
+        return (squares_x - 1) * (squares_y - 1);
+    }
+};
+
+/**
+ * @brief ChArUco 检测上下文
+ *
+ * 字典、标定板、检测参数和亚像素迭代规则在构造时只创建一次，
+ * 之后 Detect() 只读访问这些成员，可以在多个 OpenMP 线程之间共享同一个对象
+ */
+class CharucoDetector
+{
+public:
+    explicit CharucoDetector(const CharucoBoardSpec &spec = CharucoBoardSpec());
+
+    /**
+     * @brief 检测灰度图中的 ChArUco 角点（已亚像素化），返回角点数量
+     *
+     * @param pyramid_level 大于 0 时先在缩小 2^pyramid_level 倍的图像上检测 ArUco 码，
+     *                      再把码的角点映射回原图，只在全分辨率的 ROI 内插值和亚像素化
+     * @param search_roi 非空时只在该区域内检测 ArUco 码
+     */
+    int Detect(const cv::Mat &img, std::vector<int> &corner_ids,
+               std::vector<cv::Point2f> &corners, int pyramid_level = 0,
+               const cv::Rect &search_roi = cv::Rect()) const;
+
+    const CharucoBoardSpec &Spec() const {
+        return m_spec;
+    }
+
+private:
+    CharucoBoardSpec m_spec;
+    cv::Ptr<cv::aruco::Dictionary> m_dictionary;
+    cv::Ptr<cv::aruco::CharucoBoard> m_board;
+    cv::Ptr<cv::aruco::DetectorParameters> m_params;
+    cv::TermCriteria m_criteria;  // 角点亚像素化迭代规则
+};
+
+// 金字塔粗检测相对全分辨率检测的精度和耗时统计
+struct PyramidReport
+{
+    int images = 0;
+    double coarse_ms = 0.0;
+    double full_ms = 0.0;
+    long common = 0;      // 两种方式都检测到的角点数
+    long full_only = 0;   // 只有全分辨率检测到的角点数
+    long coarse_only = 0; // 只有粗检测检测到的角点数
+    double sq_error = 0.0;
+    double max_error = 0.0;
+
+    void Add(const std::vector<int> &coarse_ids, const std::vector<cv::Point2f> &coarse_corners,
+             double coarse_time, const std::vector<int> &full_ids,
+             const std::vector<cv::Point2f> &full_corners, double full_time);
+
+    void Print() const;
+};
+
+#endif
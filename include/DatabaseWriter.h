@@ -0,0 +1,97 @@
+#ifndef _DATABASE_WRITER_H_
+#define _DATABASE_WRITER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sqlite3.h"
+
+// two_view_geometries 中已有的一行
+struct TwoViewGeometryRow
+{
+    std::vector<uint32_t> data;  // rows x 2 的内点匹配
+    int config = 0;
+    std::vector<double> F, E, H; // 为空表示 NULL
+};
+
+/**
+ * @brief COLMAP 数据库写入器
+ *
+ * 所有写入放在同一个事务里，keypoints / matches 的插入语句只 prepare 一次，
+ * 之后每行只重新绑定参数，避免逐行解析 SQL 和逐行 fsync。
+ * 插入使用 INSERT OR REPLACE，追加模式下可以直接覆盖已有的行。
+ */
+class DatabaseWriter
+{
+public:
+    DatabaseWriter();
+    ~DatabaseWriter();
+
+    // 打开已有的数据库，失败时返回 false
+    bool Open(const std::string &path);
+
+    // 删除已有文件，按 COLMAP 的表结构新建数据库并打开
+    bool Create(const std::string &path);
+    void Close();
+
+    void BeginTransaction();
+    void Commit();
+
+    // 写入一行 cameras，返回自增的 camera_id
+    int WriteCamera(int model, int width, int height, const double *params, int num_params);
+
+    void WriteImage(int image_id, const std::string &name, int camera_id);
+
+    // 把数据库文件整个读入内存，作为 CopyTemplate() 的模板；可以在多个线程中同时复制
+    static sqlite3 *LoadTemplate(const std::string &path);
+
+    // 用 SQLite backup API 把模板写成新的数据库文件，已有的文件会被覆盖
+    static bool CopyTemplate(sqlite3 *template_db, const std::string &path);
+
+    // 删除原有的 keypoints / matches / two_view_geometries 记录
+    void ClearFeatures();
+
+    // data 为 rows x cols 的 float 数组，直接绑定不拷贝，只需在调用期间有效；
+    // 以下三个函数的 data 为 nullptr 时只预留同样大小的零 blob，行号即 image_id / pair_id
+    void WriteKeypoints(int image_id, const void *data, int rows, int cols);
+
+    // data 为 rows x cols 的 uint32 数组
+    void WriteMatches(uint64_t pair_id, const void *data, int rows, int cols);
+
+    /**
+     * @brief 写入一行 two_view_geometries
+     *
+     * @param data rows x cols 的 uint32 内点匹配
+     * @param config COLMAP 的 TwoViewGeometry::ConfigurationType
+     * @param F,E,H 行优先的 3x3 double 矩阵，nullptr 表示不写（COLMAP 读出为零矩阵）
+     */
+    void WriteTwoViewGeometry(uint64_t pair_id, const void *data, int rows, int cols, int config,
+                              const double *F, const double *E, const double *H);
+
+    // 读取已有的记录，用于追加模式；记录不存在时返回 false
+    // keypoints 只读出每行的 x y 两列，data 为 rows x 2
+    bool ReadKeypoints(int image_id, std::vector<float> &data);
+    bool ReadMatches(uint64_t pair_id, std::vector<uint32_t> &data);
+    bool ReadTwoViewGeometry(uint64_t pair_id, TwoViewGeometryRow &row);
+
+    // 输出写入行数和速度
+    void PrintStats() const;
+
+    sqlite3 *Handle() {
+        return m_db;
+    }
+
+private:
+    sqlite3 *m_db;
+    sqlite3_stmt *m_keypoints_stmt;
+    sqlite3_stmt *m_matches_stmt;
+    sqlite3_stmt *m_geometries_stmt;
+    sqlite3_stmt *m_read_keypoints_stmt;
+    sqlite3_stmt *m_read_matches_stmt;
+    sqlite3_stmt *m_read_geometries_stmt;
+    size_t m_num_rows;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#endif
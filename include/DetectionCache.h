@@ -0,0 +1,56 @@
+#ifndef _DETECTION_CACHE_H_
+#define _DETECTION_CACHE_H_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief ChArUco 检测结果的磁盘缓存
+ *
+ * 以「图像路径 + 文件大小 + 修改时间」（视频再加帧号）为键保存角点 ID 和亚像素坐标，
+ * 文件头记录标定板和检测参数的哈希，参数变化后整个缓存失效。
+ * Lookup() / Insert() 可以在多个线程中同时调用。
+ */
+class DetectionCache
+{
+public:
+    explicit DetectionCache(uint64_t config_hash) : m_config_hash(config_hash), m_dirty(false) {}
+
+    // 读取缓存文件，文件不存在、损坏或检测参数不一致时返回 false，缓存保持为空
+    bool Load(const std::string &path);
+
+    // 有新结果时整体写回缓存文件
+    bool Save(const std::string &path);
+
+    // 生成文件的缓存键，文件不存在时返回 false；frame_id >= 0 表示视频中的某一帧
+    static bool FileKey(const std::string &file, int frame_id, std::string &key);
+
+    bool Lookup(const std::string &key, std::vector<int> &corner_ids,
+                std::vector<cv::Point2f> &corners) const;
+
+    void Insert(const std::string &key, const std::vector<int> &corner_ids,
+                const std::vector<cv::Point2f> &corners);
+
+    size_t Size() const;
+
+private:
+    struct Entry
+    {
+        std::vector<int> corner_ids;
+        std::vector<cv::Point2f> corners;
+    };
+
+    uint64_t m_config_hash;
+    bool m_dirty;
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+};
+
+// FNV-1a 哈希，用于生成检测参数的指纹
+uint64_t Fnv1aHash(const void *data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+#endif
@@ -7,8 +7,16 @@
 #include <unordered_map>
 #include <fstream>
 #include <set>
-#include "HashFunc.h"
 #include "Utilities.h"
+#include "DatabaseWriter.h"
+#include "CameraCache.h"
+#include "CharucoDetector.h"
+#include "DetectionCache.h"
+#include "Observations.h"
+#include "PointProjector.h"
+#include "StreamingExport.h"
+#include "TrackStore.h"
+#include "TwoViewGeometry.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/aruco.hpp>
@@ -17,31 +25,52 @@
 #include <opencv2/imgproc/imgproc_c.h>
 #include <boost/format.hpp>
 #include <random>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <memory>
 
 using namespace std;
 using namespace cv;
 
-struct MatchData 
+// 一张图像的检测结果
+struct ViewDetection
 {
-    MatchData(int num) {
-        pixel_points.resize(num, {-1.0f, -1.0f});
-    }
-    // 添加检测到的(u,v)坐标
-    void FillData(int view_id, float u, float v) {
-        pixel_points[view_id].first = u;
-        pixel_points[view_id].second = v;
-    }
-    // pixel_points[i]表示当前点在视图i里的像素坐标
-    std::vector<std::pair<float, float>> pixel_points;
+    vector<int> marker_ids;
+    vector<Point2f> marker_corners;
+};
+
+// Match() 的运行参数
+struct MatchOptions
+{
+    int io_threads = 0;     // 读图解码线程数，0 表示不使用流水线，直接用 OpenMP 并行
+    int detect_threads = 0; // 流水线中的检测线程数，0 表示使用全部核心
+    int queue_size = 64;    // 流水线各级队列的容量（图像数）
+    int pyramid_level = 0;  // 大于 0 时在缩小 2^pyramid_level 倍的图像上粗检测 ArUco 码
+    bool pyramid_report = false; // 同时做全分辨率检测，统计粗检测的精度和加速比
+    bool roi_tracking = false;   // 先在上一组标定板位置附近搜索，未检测到再全图检测
+    float roi_padding = 0.5f;    // 搜索区域向四周扩展的比例（相对标定板包围盒的长边）
+    std::string video_path;      // 非空时从每个相机一个的视频中逐组读帧，%d 为相机编号
+    std::string cache_path;      // 检测结果缓存文件，为空时不使用缓存
+    std::string observations_path = "./observations.bin"; // 有效观测的二进制文件，为空时不写
+};
+
+// 相机上一次检测到标定板的位置
+struct TrackedRoi
+{
+    int group_idx = -1;
+    int num_corners = 0;
+    Rect box;
 };
 
 struct MatcherBase {
     void CreateIdMap(const std::string& db_path);
 
-    // 分组添加点 添加MatchData
-    virtual void Match(const std::string &image_path, int group_num, int view_num, unordered_map<string, int>& jpg2Cam, int cam_start, int group_start) = 0;
+    // 分组添加点 添加到 m_match_data
+    virtual void Match(const std::string &image_path, int group_num, int view_num, const unordered_map<string, int>& jpg2Cam, int cam_start, int group_start) = 0;
 
-    std::vector<MatchData> m_match_data;
+    // 第 t 条轨迹：ArUco 模式下为第 t / 角点数 组的第 t % 角点数 号角点，随机点模式下为第 t 个三维点
+    TrackStore m_match_data;
     std::unordered_map<std::string, int> m_cam_id;
 };
 
@@ -51,16 +80,63 @@ public:
     Matcher() {};
 
     std::vector<std::vector<std::string>> imageVector;
+    CharucoBoardSpec m_board_spec;  // Match() 使用的标定板规格
+    MatchOptions m_options;
 
     void ReadImages(const std::string& image_path, int num_group, int num_view, int camera_name_start, int groupStart);
     
-    void Match(const std::string &image_path, int group_num, int view_num, unordered_map<string, int>& jpg2Cam, int cam_start, int group_start);
+    void Match(const std::string &image_path, int group_num, int view_num, const unordered_map<string, int>& jpg2Cam, int cam_start, int group_start);
+
+    // 把 Match() 新增的检测结果写回缓存文件，多次调用 Match() 时只需在最后调用一次
+    void SaveDetectionCache();
 
+    // 从 xmlPath（%d 为相机编号）读取各视图投影矩阵真值到 m_proj，
+    // 解析结果缓存在 xml 目录下的 cameras.sqcm，xml 未变化时直接映射缓存
+    void LoadProjections(const string &xmlPath, int cameraNumber);
+
+    // seed 相同时生成的点与线程数无关，完全一致；m_proj 已有 cameraNumber 个相机时不再读取 xml
     void generateRandomPoints(const string &xmlPath, int cameraNumber, int maxPoints,
                                    vector<vector<int>> boxSize, vector<int> trackRange, int noise2D,
-                                   bool has_circle, bool is_track_exp);
-                                   
+                                   bool has_circle, bool is_track_exp, uint64_t seed);
+
+    // LoadProjections() 读入的各视图投影矩阵真值和图像尺寸
+    ProjectionList m_proj;
+    ImageSizeList m_image_sizes;
+
     virtual ~Matcher() {};
+
+private:
+    // 检测一张图像，返回检测耗时（毫秒）
+    double DetectImage(const CharucoDetector &detector, int group_idx, int cam_id, const Mat &img,
+                       vector<int> &marker_ids, vector<Point2f> &marker_corners);
+
+    // 暂存一张图像的检测结果，全部检测完成后由 BuildTracks() 汇总
+    void StoreDetection(int group_idx, int cam_id, vector<int> marker_ids,
+                        vector<Point2f> marker_corners);
+
+    // 把各图像的检测结果按 (组, 角点 ID) 汇总成 CSR 轨迹
+    void BuildTracks(int group_num, int cam_num);
+
+    // 读图 / 检测 / 保存 三级流水线，返回检测耗时总和（毫秒）
+    // image_names[group_idx * cam_num + cam_id] 为预先生成的图像路径，视频模式下为空
+    double MatchPipelined(const CharucoDetector &detector, const vector<string> &image_names,
+                          int group_num, int cam_num, int cam_start, int group_start);
+
+    PyramidReport m_pyramid_report;
+    std::mutex m_report_mutex;
+
+    // 各相机的标定板跟踪状态，跨组保留
+    std::vector<TrackedRoi> m_track_roi;
+    std::mutex m_roi_mutex;
+    std::atomic<int> m_roi_hits{0};
+    std::atomic<int> m_roi_misses{0};
+
+    std::unique_ptr<DetectionCache> m_cache;
+    std::atomic<int> m_cache_hits{0};
+
+    // m_views[group_idx * cam_num + view_id]
+    std::vector<ViewDetection> m_views;
+    std::vector<int> m_view_ids;  // 相机序号 -> 数据库中的视图 ID，-1 表示数据库中没有该图像
 };
 
 struct Camera {
@@ -68,8 +144,8 @@ struct Camera {
     typedef std::pair<int, int> pii;
 
     int m_id;
-    std::unordered_map<pff, int, HashFunc<pff>> m_keypoints;
-    std::vector<std::vector<pii>> m_matches;
+    std::vector<pff> m_keypoints;  // m_keypoints[i] 为第 i 个特征点的像素坐标
+    std::vector<std::vector<pii>> m_matches;  // m_matches[j] 为与第 j 个相机的匹配，只使用 j 大于自身序号的部分
 
     Camera(int id, int num):m_id(id) { // 相机总数
         m_matches.resize(num);
@@ -83,42 +159,45 @@ struct Camera {
         return m_id;
     }
 
-    const int PointId(const pff& point) {
-        int result = m_keypoints[point];
-        return result;
-    }
-
     const int NumKeypoints() {
         return m_keypoints.size();
     }
 
-    bool AddKeypoints(const pff& point, int id_expected) {
-        if(m_keypoints.count(point)) {
-            return false;
-        }
-        m_keypoints[point] = id_expected;
-        return true;
+    // 每个观测都对应唯一的 (轨迹, 视图)，直接按顺序分配特征点 id，无需查重
+    int AddKeypoint(const pff& point) {
+        m_keypoints.push_back(point);
+        return static_cast<int>(m_keypoints.size()) - 1;
     }
 
-    void AddMatches(const std::vector<int>& ids) {
-        int n(ids.size());
-        int src_id = ids[m_id - 1];
-        if(src_id < 0) {
-            return;
-        }
-        for(int i = 0; i < n; ++i) {
-            if(i == m_id - 1 || ids[i] == -1) {
-                continue;
-            }
-            m_matches[i].push_back({src_id, ids[i]});
-        }
-    }
+};
 
-    
+// ExtractToDatabase() 的导出参数
+struct ExportOptions
+{
+    bool write_geometries = false; // 直接写入 two_view_geometries，不再需要 colmap matches_importer
+    ProjectionList proj_matrices;  // 各视图 3x4 投影矩阵真值，非空时据此写入 F 和 E
+    bool verify = false;           // 用 RANSAC 估计每个相机对的 F 并剔除外点，隐含 write_geometries
+    VerifyOptions verify_options;
+    bool append = false;           // 保留数据库中已有的特征点和匹配，只追加本次检测的组
 };
 
-void ExtractToDatabase(int num_cam, const std::string& db_path, const std::string& txt_path, const std::vector<MatchData>& data, std::unordered_map<int, std::string>& cam_name);
+void ExtractToDatabase(int num_cam, const std::string& db_path, const std::string& txt_path, const TrackStore& data, std::unordered_map<int, std::string>& cam_name, const ExportOptions& options = ExportOptions());
+
+// 数据库 images 表中的图像名：第 group_id 组、cam_id 号相机图像路径的文件名，image_path 为空时为 %04d.png
+std::string ViewName(const std::string& image_path, int group_id, int cam_id);
 
 void CreateIdMap(const std::string& db_path, std::unordered_map<std::string, int>& cam_id, std::unordered_map<int, std::string>& cam_name);
 
+/**
+ * @brief 新建 COLMAP 数据库并写入 cameras / images 表，代替 feature_extractor + exhaustive_matcher
+ *
+ * 每个相机一张图像、一个相机模型，图像尺寸从第 group_start 组图像的文件头读取，
+ * 焦距按 1.2 * max(width, height) 估计。输出的映射与 CreateIdMap() 相同。
+ *
+ * @param image_path 图像路径格式，与 Match() 相同，为空时按 %04d.png 命名、尺寸取 1920x1080
+ * @param camera_model COLMAP 相机模型名，如 OPENCV、PINHOLE、SIMPLE_RADIAL
+ * @return 失败时返回 false
+ */
+bool CreateDatabase(const std::string& db_path, const std::string& image_path, int cam_num, int cam_start, int group_start, const std::string& camera_model, std::unordered_map<std::string, int>& cam_id, std::unordered_map<int, std::string>& cam_name);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef _OBSERVATIONS_H_
+#define _OBSERVATIONS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TrackStore.h"
+
+// 一条二维观测：第 track_id 条轨迹（三维点）在 cam_id 视图中的像素坐标
+struct Observation
+{
+    uint32_t track_id;  // 相对 track_offset 的编号
+    uint32_t cam_id;
+    float u;
+    float v;
+};
+
+/**
+ * @brief 二进制观测文件，替代原来的 log.txt 文本
+ *
+ * 文件布局（小端）：
+ *   char[4]  magic "SQOB"
+ *   uint32   version
+ *   uint32   cam_num
+ *   uint32   reserved
+ *   uint64   track_offset  第一条轨迹的全局编号
+ *   uint64   num_tracks
+ *   uint64   num_observations
+ *   Observation[num_observations]  只保存有效观测，按 track_id 升序
+ */
+struct ObservationFile
+{
+    uint32_t cam_num = 0;
+    uint64_t track_offset = 0;
+    uint64_t num_tracks = 0;
+    std::vector<Observation> observations;
+};
+
+// 一次写入整个文件
+bool WriteObservations(const std::string &path, const ObservationFile &file);
+
+// 一次读入整个文件，格式或版本不符、cam_id 越界或 track_id 不是升序且小于 num_tracks 时返回 false
+bool ReadObservations(const std::string &path, ObservationFile &file);
+
+// 只读取文件头，file.observations 为空，观测数由 num_observations 返回
+bool ReadObservationHeader(const std::string &path, ObservationFile &file,
+                           uint64_t &num_observations);
+
+// 按 track_id 顺序把文件中的 num_tracks 条轨迹追加到 tracks，与写出前的 TrackStore 一致
+void AppendTracks(const ObservationFile &file, TrackStore &tracks);
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef _POINT_PROJECTOR_H_
+#define _POINT_PROJECTOR_H_
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <Eigen/Core>
+
+#include "TwoViewGeometry.h"
+
+typedef std::vector<Eigen::Vector2i> ImageSizeList;
+
+/**
+ * @brief 把一批三维点一次投影到所有相机
+ *
+ * 各相机 P 的三行分别堆叠成 cam_num x 4 的矩阵，一批 N 个齐次点为 4 x N，
+ * 三次矩阵乘法得到所有相机下的齐次像素坐标，透视除法和图像范围判断都按整块数组计算，
+ * 不再为每个点、每个相机构造 cv::Mat。
+ */
+class PointProjector
+{
+public:
+    // image_sizes[cam_id] 为 (宽, 高)，为空时所有相机都按 1920x1080
+    PointProjector(const ProjectionList &proj, const ImageSizeList &image_sizes = ImageSizeList());
+
+    int NumCameras() const {
+        return m_rows_u.rows();
+    }
+
+    /**
+     * @brief 投影一批点
+     *
+     * @param points 4 x N 齐次坐标
+     * @param u,v 输出 cam_num x N 像素坐标
+     */
+    void Project(const Eigen::Ref<const Eigen::Matrix4Xd> &points, Eigen::MatrixXd &u,
+                 Eigen::MatrixXd &v) const;
+
+    // 齐次坐标的第三维（深度的符号），输出 cam_num x N
+    void Depth(const Eigen::Ref<const Eigen::Matrix4Xd> &points, Eigen::MatrixXd &w) const;
+
+    // 像素范围 [u_min, u_max] x [v_min, v_max] 是否与 cam_id 的图像范围相交
+    bool Overlaps(int cam_id, double u_min, double u_max, double v_min, double v_max) const;
+
+    // (u, v) 是否落在图像范围内，输出 cam_num x N
+    void Visible(const Eigen::MatrixXd &u, const Eigen::MatrixXd &v,
+                 Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> &visible) const;
+
+private:
+    Eigen::Matrix<double, Eigen::Dynamic, 4> m_rows_u; // 各相机 P 的第 0 行
+    Eigen::Matrix<double, Eigen::Dynamic, 4> m_rows_v;
+    Eigen::Matrix<double, Eigen::Dynamic, 4> m_rows_w;
+    Eigen::ArrayXd m_width;  // 各相机的图像宽度
+    Eigen::ArrayXd m_height;
+};
+
+/**
+ * @brief 三维范围内的共视数量网格，用于直接采样满足共视要求的点
+ *
+ * 把 box 均分成 cells_per_axis^3 个单元，由 8 个角点的投影保守判断每个相机能否看到单元的
+ * 某一部分，至少 min_views 个相机可能看到的单元作为候选区域。投影之后还会加上二维噪声时，
+ * margin 取噪声绝对值的上界，图像范围向外扩展 margin 像素再判断，
+ * 这样候选区域包含所有加噪声后满足共视要求的点，Sample() 在其中均匀采样整数坐标后再逐点剔除，
+ * 与在整个 box 内均匀采样再剔除得到的分布相同，但废点少得多。
+ */
+class VisibilityGrid
+{
+public:
+    // box 为 XYZ 三个轴的整数范围（闭区间），margin 为像素噪声绝对值的上界
+    VisibilityGrid(const PointProjector &projector, const std::vector<std::vector<int>> &box,
+                   int min_views, double margin = 0, int cells_per_axis = 32);
+
+    Eigen::Vector3d Sample(std::mt19937_64 &generator) const;
+
+    // 候选区域占整个 box 的体积比例
+    double Fraction() const;
+
+private:
+    std::vector<int> m_edges[3];      // 第 i 个单元覆盖 [m_edges[i], m_edges[i + 1])
+    std::vector<int> m_cells;         // 候选单元编号 (z * n_y + y) * n_x + x
+    std::vector<uint64_t> m_prefix;   // 候选单元整数点数的前缀和
+    uint64_t m_box_points;
+};
+
+// 对比逐点 cv::Mat 投影和批量投影的速度（点/秒），并检查两者结果一致
+void BenchmarkProjection(const ProjectionList &proj, int num_points);
+
+#endif
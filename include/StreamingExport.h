@@ -0,0 +1,77 @@
+#ifndef _STREAMING_EXPORT_H_
+#define _STREAMING_EXPORT_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "TrackStore.h"
+#include "sqlite3.h"
+#include "TwoViewGeometry.h"
+
+/**
+ * @brief 内存有界的流式导出
+ *
+ * 检测按组分块进行，每块的轨迹通过 AddChunk() 立即生成特征点和匹配，
+ * 追加写入两个临时溢出文件（特征点、匹配），内存中只记录每个相机 / 相机对在文件中的分段。
+ * 最后 WriteDatabase() 逐个相机 / 相机对预留 zeroblob，再用固定大小的缓冲区
+ * 把各分段依次拷贝进 blob，内存占用与组数无关。
+ *
+ * 特征点 id 和匹配的顺序与 ExtractToDatabase() 一次性导出的结果完全一致。
+ */
+class StreamingExporter
+{
+public:
+    // spill_dir 为溢出文件所在目录
+    StreamingExporter(int num_cam, const std::string &spill_dir);
+    ~StreamingExporter();
+
+    bool Open();
+
+    // 追加一块轨迹，相机 id 为 0 ~ num_cam-1
+    void AddChunk(const TrackStore &data);
+
+    /**
+     * @brief 合并溢出文件，写入 keypoints / matches（以及 two_view_geometries 或 match.txt）
+     *
+     * @param write_geometries 为 true 时直接写 two_view_geometries，否则写 match.txt
+     * @param proj_matrices 各视图投影矩阵真值，非空时写入 F 和 E
+     * @param buffer_bytes 拷贝缓冲区大小
+     */
+    bool WriteDatabase(const std::string &db_path, const std::string &txt_path,
+                       std::unordered_map<int, std::string> &cam_name, bool write_geometries,
+                       const ProjectionList &proj_matrices, size_t buffer_bytes);
+
+private:
+    // 溢出文件中的一段：从 offset 开始的 count 行
+    struct Segment
+    {
+        uint64_t offset;
+        uint32_t count;
+    };
+
+    // 用 m_buffer 依次读出 segments，每读满一次缓冲区调用一次 sink，sink 返回 false 时中止
+    bool ReadSegments(FILE *file, const std::vector<Segment> &segments, size_t row_bytes,
+                      const std::function<bool(const char *, size_t)> &sink);
+
+    // 把 segments 依次拷贝进 table 表 rowid 行已预留的 data 列
+    bool CopyToBlob(sqlite3 *db, const char *table, int64_t rowid, FILE *file,
+                    const std::vector<Segment> &segments, size_t row_bytes);
+
+    int m_num_cam;
+    std::string m_keypoints_path;
+    std::string m_matches_path;
+    FILE *m_keypoints_file;
+    FILE *m_matches_file;
+    std::vector<uint32_t> m_num_keypoints;               // 每个相机已分配的特征点数
+    std::vector<uint64_t> m_num_matches;                 // 第 i * num_cam + j 个相机对的匹配数
+    std::vector<std::vector<Segment>> m_keypoint_segments; // 每个相机
+    std::vector<std::vector<Segment>> m_match_segments;    // 每个相机对
+    std::vector<char> m_buffer;
+    int m_num_chunks;
+};
+
+#endif
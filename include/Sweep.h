@@ -0,0 +1,45 @@
+#ifndef _SWEEP_H_
+#define _SWEEP_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Matcher.h"
+
+// 参数网格，每一项的所有取值做笛卡尔积
+struct SweepOptions
+{
+    std::vector<int> pixel_errors;
+    std::vector<int> track_lengths; // 依次为若干组 (最小值, 最大值)
+    std::vector<int> max_points;
+    int jobs = 0;                   // 同时运行的配置数，0 表示使用全部核心
+};
+
+// 一组随机点实验参数
+struct SweepConfig
+{
+    int pixel_error;
+    std::vector<int> track_length;
+    int max_points;
+    std::string name;  // 输出子目录名
+};
+
+// 展开参数网格，某一项为空时使用 defaults 中的取值；轨迹长度不成对时报错并返回空
+std::vector<SweepConfig> ExpandSweepGrid(const SweepOptions &options, const SweepConfig &defaults);
+
+/**
+ * @brief 随机点实验的参数扫描
+ *
+ * 真值相机只读取一次（base.m_proj），数据库模板只从 project_path/database.db 读入内存一次，
+ * 每组参数在 project_path/sweep/<name>/ 下由模板复制出自己的数据库并导出，
+ * 各组参数并行运行，内部的 OpenMP 并行区退化为单线程。
+ * seed 对所有配置相同，生成结果与串行逐个运行 Extract 一致。
+ */
+void RunSweep(const std::vector<SweepConfig> &configs, const SweepOptions &options,
+              const Matcher &base, const std::string &project_path, int cam_num,
+              const std::vector<std::vector<int>> &box_size, bool has_circle, bool is_track_exp,
+              uint64_t seed, const std::unordered_map<int, std::string> &cam_name,
+              const ExportOptions &export_options);
+
+#endif
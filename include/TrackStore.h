@@ -0,0 +1,82 @@
+#ifndef _TRACK_STORE_H_
+#define _TRACK_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 压缩稀疏行（CSR）格式的轨迹存储
+ *
+ * 第 t 条轨迹（三维点）的观测位于 [m_offsets[t], m_offsets[t + 1])，
+ * 每条观测由 m_cam_ids / m_u / m_v 三个平铺数组中的同一下标描述，
+ * 只保存有效观测，不再为不可见的视图保存 (-1, -1)。
+ */
+struct TrackStore
+{
+    std::vector<uint32_t> m_offsets{0};
+    std::vector<uint16_t> m_cam_ids;
+    std::vector<float> m_u;
+    std::vector<float> m_v;
+    int m_cam_num = 0;
+
+    void Reset(int cam_num) {
+        m_offsets.assign(1, 0);
+        m_cam_ids.clear();
+        m_u.clear();
+        m_v.clear();
+        m_cam_num = cam_num;
+    }
+
+    void Reserve(size_t num_tracks, size_t num_obs) {
+        m_offsets.reserve(num_tracks + 1);
+        m_cam_ids.reserve(num_obs);
+        m_u.reserve(num_obs);
+        m_v.reserve(num_obs);
+    }
+
+    // 向当前轨迹追加一条观测，同一条轨迹内按相机 id 升序添加
+    void AddObservation(int cam_id, float u, float v) {
+        m_cam_ids.push_back(static_cast<uint16_t>(cam_id));
+        m_u.push_back(u);
+        m_v.push_back(v);
+    }
+
+    // 结束当前轨迹，之后的观测属于下一条轨迹
+    void FinishTrack() {
+        m_offsets.push_back(static_cast<uint32_t>(m_cam_ids.size()));
+    }
+
+    size_t NumTracks() const {
+        return m_offsets.size() - 1;
+    }
+
+    size_t NumObservations() const {
+        return m_cam_ids.size();
+    }
+
+    uint32_t Begin(size_t track_id) const {
+        return m_offsets[track_id];
+    }
+
+    uint32_t End(size_t track_id) const {
+        return m_offsets[track_id + 1];
+    }
+
+    // 实际占用的内存（字节）
+    size_t MemoryBytes() const {
+        return m_offsets.capacity() * sizeof(uint32_t) + m_cam_ids.capacity() * sizeof(uint16_t) +
+               (m_u.capacity() + m_v.capacity()) * sizeof(float);
+    }
+
+    // 若按每条轨迹 cam_num 个 (u, v) 的稠密方式存储需要的内存（字节），用于对比
+    size_t DenseMemoryBytes() const {
+        return NumTracks() * (sizeof(std::vector<std::pair<float, float>>) +
+                              m_cam_num * sizeof(std::pair<float, float>));
+    }
+
+    void PrintStats(const char *name, double build_ms) const;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef _TWO_VIEW_GEOMETRY_H_
+#define _TWO_VIEW_GEOMETRY_H_
+
+#include <cstdint>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+typedef Eigen::Matrix<double, 3, 4> Matrix3x4d;
+typedef std::vector<Matrix3x4d, Eigen::aligned_allocator<Matrix3x4d>> ProjectionList;
+
+// 与 COLMAP TwoViewGeometry::ConfigurationType 取值一致
+enum TwoViewConfig
+{
+    TWO_VIEW_CALIBRATED = 2,
+    TWO_VIEW_UNCALIBRATED = 3,
+};
+
+// 由两个视图的投影矩阵计算基础矩阵 F，满足 x2^T * F * x1 = 0，返回 Frobenius 范数归一化的结果
+Eigen::Matrix3d FundamentalFromProjections(const Matrix3x4d &P1, const Matrix3x4d &P2);
+
+// 对投影矩阵左侧 3x3 部分做 RQ 分解得到内参 K（K(2, 2) = 1）
+Eigen::Matrix3d IntrinsicsFromProjection(const Matrix3x4d &P);
+
+// E = K2^T * F * K1
+Eigen::Matrix3d EssentialFromFundamental(const Eigen::Matrix3d &F, const Eigen::Matrix3d &K1,
+                                         const Eigen::Matrix3d &K2);
+
+// RANSAC 估计基础矩阵的参数
+struct VerifyOptions
+{
+    double max_error = 4.0;      // Sampson 距离阈值（像素）
+    double confidence = 0.999;
+    int max_iterations = 2000;
+    int min_inliers = 15;        // 内点少于该值的相机对不写入 two_view_geometries
+};
+
+/**
+ * @brief 归一化八点法 + RANSAC 估计基础矩阵
+ *
+ * @param pts1,pts2 对应点的像素坐标
+ * @param seed 随机种子，相同输入和种子得到相同结果
+ * @param F 输出的基础矩阵，满足 x2^T * F * x1 = 0
+ * @param inlier_mask 输出每个对应是否为内点
+ * @return 内点数量，对应少于 8 个时返回 0
+ */
+int EstimateFundamentalRansac(const std::vector<Eigen::Vector2d> &pts1,
+                              const std::vector<Eigen::Vector2d> &pts2,
+                              const VerifyOptions &options, uint64_t seed, Eigen::Matrix3d &F,
+                              std::vector<char> &inlier_mask);
+
+// 用带离群点的合成双视图数据检查 EstimateFundamentalRansac() 能否找回真实内点，
+// 输出内点找回率，找回不足 95% 时返回 false
+bool CheckFundamentalRansac(const VerifyOptions &options, int num_points, double outlier_ratio,
+                            uint64_t seed = 0);
+
+#endif
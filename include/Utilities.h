@@ -11,3 +11,6 @@
 #include "sqlite3.h"
 
 uint64_t ImageIdsToPairId(uint32_t id1, uint32_t id2);
+
+// 只读取 PNG / JPEG 文件头得到图像尺寸，不解码像素；失败时返回 false
+bool ReadImageSize(const std::string &path, int &width, int &height);
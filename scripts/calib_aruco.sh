@@ -11,13 +11,6 @@ img_idx=0
 echo "----- step1: construct colmap database +++++"
 mkdir ./$RESULT
 cp -r ./$img_idx ./$RESULT/color
-colmap feature_extractor \
-    --database_path ./$RESULT/database.db \
-    --image_path ./$img_idx\
-    --ImageReader.camera_model OPENCV
-
-colmap exhaustive_matcher \
-    --database_path ./$RESULT/database.db
 
 # 步骤 2
 echo "----- step2: generate random 3D points to database +++++"
@@ -32,17 +25,15 @@ ${CODE_PATH}/build/Extract \
     --max_points 21000 \
     --pixel_error 1 \
     --track_length 7 20 \
-    --axis_range -500 500 -500 500 0 1000
+    --axis_range -500 500 -500 500 0 1000 \
+    --create_database 1 \
+    --camera_model OPENCV \
+    --write_geometries 1
 
 # 步骤 3
 echo "----- step3: Construction +++++"
 DATASET_PATH="./$RESULT"
 
-echo "----- step3.1: matches_importer +++++"
-colmap matches_importer --database_path $DATASET_PATH/database.db \
-                        --match_list_path $DATASET_PATH/match.txt \
-                        --match_type 'inliers'
-
 # colmap automatic_reconstructor --workspace_path $DATASET_PATH \
 #                                 --image_path $DATASET_PATH/color \
 #                                 --quality extreme \
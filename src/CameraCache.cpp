@@ -0,0 +1,116 @@
+#include "CameraCache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const char kCameraCacheMagic[4] = {'S', 'Q', 'C', 'M'};
+const uint32_t kCameraCacheVersion = 2;
+
+struct CameraCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t cam_num;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CameraCacheHeader) == 16, "CameraCacheHeader must be tightly packed");
+static_assert(sizeof(CameraRecord) == 128, "CameraRecord must be tightly packed");
+
+}  // namespace
+
+CameraCache::~CameraCache() {
+    Unmap();
+}
+
+void CameraCache::Unmap() {
+    if (m_data != nullptr) {
+        munmap(m_data, m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_records = nullptr;
+    m_num_cameras = 0;
+}
+
+bool CameraCache::Load(const std::string &path, const std::vector<std::string> &xml_paths) {
+    Unmap();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(CameraCacheHeader)) {
+        close(fd);
+        return false;
+    }
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    m_data = data;
+    m_size = st.st_size;
+
+    const CameraCacheHeader *header = static_cast<const CameraCacheHeader *>(data);
+    if (memcmp(header->magic, kCameraCacheMagic, 4) != 0 ||
+        header->version != kCameraCacheVersion || header->cam_num != xml_paths.size() ||
+        m_size != sizeof(CameraCacheHeader) + header->cam_num * sizeof(CameraRecord)) {
+        Unmap();
+        return false;
+    }
+    m_records = reinterpret_cast<const CameraRecord *>(header + 1);
+    for (int cam_id = 0; cam_id < xml_paths.size(); ++cam_id) {
+        CameraRecord current;
+        if (!StatXml(xml_paths[cam_id], current) ||
+            current.xml_size != m_records[cam_id].xml_size ||
+            current.xml_mtime_sec != m_records[cam_id].xml_mtime_sec ||
+            current.xml_mtime_nsec != m_records[cam_id].xml_mtime_nsec) {
+            Unmap();
+            return false;
+        }
+    }
+    m_num_cameras = header->cam_num;
+    return true;
+}
+
+bool CameraCache::Save(const std::string &path, const std::vector<CameraRecord> &records) {
+    std::string tmp_path(path + ".tmp");
+    std::ofstream fs(tmp_path, std::ios::binary);
+    if (!fs.is_open()) {
+        printf("error open camera cache %s\n", tmp_path.c_str());
+        return false;
+    }
+    CameraCacheHeader header;
+    memcpy(header.magic, kCameraCacheMagic, 4);
+    header.version = kCameraCacheVersion;
+    header.cam_num = records.size();
+    header.reserved = 0;
+    fs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    fs.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(CameraRecord));
+    fs.close();
+    if (!fs || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        printf("error write camera cache %s\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CameraCache::StatXml(const std::string &xml_path, CameraRecord &record) {
+    struct stat st;
+    if (stat(xml_path.c_str(), &st) != 0) {
+        return false;
+    }
+    record.xml_size = st.st_size;
+    record.xml_mtime_sec = st.st_mtim.tv_sec;
+    record.xml_mtime_nsec = st.st_mtim.tv_nsec;
+    return true;
+}
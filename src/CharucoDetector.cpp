@@ -0,0 +1,144 @@
+#include "CharucoDetector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+CharucoDetector::CharucoDetector(const CharucoBoardSpec &spec)
+    : m_spec(spec),
+      m_criteria(cv::TermCriteria::EPS + cv::TermCriteria::MAX_ITER, 40, 0.001) {
+    m_dictionary = cv::aruco::getPredefinedDictionary(m_spec.dictionary);
+    m_board = cv::aruco::CharucoBoard::create(m_spec.squares_x, m_spec.squares_y,
+                                              m_spec.square_length, m_spec.marker_length,
+                                              m_dictionary);
+    m_params = cv::aruco::DetectorParameters::create();
+}
+
+int CharucoDetector::Detect(const cv::Mat &img, std::vector<int> &corner_ids,
+                            std::vector<cv::Point2f> &corners, int pyramid_level,
+                            const cv::Rect &search_roi) const {
+    corner_ids.clear();
+    corners.clear();
+    if (img.empty()) { // 读图失败
+        return 0;
+    }
+
+    cv::Rect frame(0, 0, img.cols, img.rows);
+    cv::Rect search = search_roi.empty() ? frame : (search_roi & frame);
+    if (search.empty()) {
+        return 0;
+    }
+    cv::Mat search_img = img(search);
+
+    std::vector<int> aruco_ids;
+    std::vector<std::vector<cv::Point2f>> aruco_corners;
+    if (pyramid_level > 0) {
+        // 在缩小后的图像上做自适应阈值和码检测
+        float scale = static_cast<float>(1 << pyramid_level);
+        cv::Mat small;
+        cv::resize(search_img, small, cv::Size(), 1.0 / scale, 1.0 / scale, cv::INTER_AREA);
+        cv::aruco::detectMarkers(small, m_board->dictionary, aruco_corners, aruco_ids, m_params);
+        // 像素中心对齐后映射回原图坐标
+        for (auto &marker : aruco_corners) {
+            for (auto &pt : marker) {
+                pt.x = (pt.x + 0.5f) * scale - 0.5f;
+                pt.y = (pt.y + 0.5f) * scale - 0.5f;
+            }
+        }
+    } else {
+        cv::aruco::detectMarkers(search_img, m_board->dictionary, aruco_corners, aruco_ids, m_params);
+        // ! 如果是 OpenCV4 或更高版本，可能要改成下面这个写法
+        // cv::aruco::detectMarkers(search_img, m_board->getDictionary(), aruco_corners, aruco_ids, m_params);
+    }
+    if (aruco_ids.empty()) {
+        return 0;
+    }
+    for (auto &marker : aruco_corners) {
+        for (auto &pt : marker) {
+            pt.x += search.x;
+            pt.y += search.y;
+        }
+    }
+
+    // 全分辨率下只处理包含所有码的 ROI，四周留出一个码的边长，保证外圈角点也在 ROI 内
+    cv::Rect roi(frame);
+    if (pyramid_level > 0 || search != frame) {
+        std::vector<cv::Point2f> all_corners;
+        float pad(0.0f);
+        for (const auto &marker : aruco_corners) {
+            for (int k = 0; k < marker.size(); ++k) {
+                all_corners.push_back(marker[k]);
+                cv::Point2f edge = marker[(k + 1) % marker.size()] - marker[k];
+                pad = std::max(pad, std::sqrt(edge.x * edge.x + edge.y * edge.y));
+            }
+        }
+        cv::Rect box = cv::boundingRect(all_corners);
+        int pad_px = static_cast<int>(std::ceil(pad));
+        box = cv::Rect(box.x - pad_px, box.y - pad_px, box.width + 2 * pad_px,
+                       box.height + 2 * pad_px);
+        roi = box & roi;
+        for (auto &marker : aruco_corners) {
+            for (auto &pt : marker) {
+                pt.x -= roi.x;
+                pt.y -= roi.y;
+            }
+        }
+    }
+    cv::Mat img_roi = img(roi);
+
+    // 检测到 ArUco，插值得到棋盘格角点
+    cv::aruco::interpolateCornersCharuco(aruco_corners, aruco_ids, img_roi, m_board, corners,
+                                         corner_ids);
+    if (corner_ids.empty()) {
+        return 0;
+    }
+    cv::cornerSubPix(img_roi, corners, cv::Size(5, 5), cv::Size(-1, -1), m_criteria);
+    for (auto &pt : corners) {
+        pt.x += roi.x;
+        pt.y += roi.y;
+    }
+    return static_cast<int>(corner_ids.size());
+}
+
+void PyramidReport::Add(const std::vector<int> &coarse_ids,
+                        const std::vector<cv::Point2f> &coarse_corners, double coarse_time,
+                        const std::vector<int> &full_ids,
+                        const std::vector<cv::Point2f> &full_corners, double full_time) {
+    ++images;
+    coarse_ms += coarse_time;
+    full_ms += full_time;
+    std::map<int, cv::Point2f> full_map;
+    for (int i = 0; i < full_ids.size(); ++i) {
+        full_map[full_ids[i]] = full_corners[i];
+    }
+    for (int i = 0; i < coarse_ids.size(); ++i) {
+        auto it = full_map.find(coarse_ids[i]);
+        if (it == full_map.end()) {
+            ++coarse_only;
+            continue;
+        }
+        cv::Point2f diff = coarse_corners[i] - it->second;
+        double err2 = diff.x * diff.x + diff.y * diff.y;
+        sq_error += err2;
+        max_error = std::max(max_error, std::sqrt(err2));
+        ++common;
+        full_map.erase(it);
+    }
+    full_only += full_map.size();
+}
+
+void PyramidReport::Print() const {
+    if (images == 0) {
+        return;
+    }
+    std::cout << "金字塔粗检测 vs 全分辨率检测 (" << images << " 张):" << std::endl;
+    std::cout << "  平均耗时: " << coarse_ms / images << " ms vs " << full_ms / images
+              << " ms, 加速比 " << (coarse_ms > 0 ? full_ms / coarse_ms : 0.0) << std::endl;
+    std::cout << "  共同角点 " << common << ", 仅全分辨率 " << full_only << ", 仅粗检测 "
+              << coarse_only << std::endl;
+    if (common > 0) {
+        std::cout << "  角点偏差 RMS " << std::sqrt(sq_error / common) << " px, 最大 "
+                  << max_error << " px" << std::endl;
+    }
+}
@@ -0,0 +1,300 @@
+#include "DatabaseWriter.h"
+
+#include <cstdio>
+
+// unit.hpp 中的函数没有声明为 inline，只能在这一个源文件中包含
+#include "unit.hpp"
+
+namespace {
+
+// 以 SQLITE_STATIC 绑定调用方的内存，不做拷贝；空数组绑定为长度为 0 的 blob 而不是 NULL，
+// data 为 nullptr 时预留 num_bytes 的零 blob，之后用 sqlite3_blob_write 填充
+void BindBlob(sqlite3_stmt *stmt, int index, const void *data, size_t num_bytes) {
+    if (num_bytes == 0 || data == nullptr) {
+        SQLITE3_CALL(sqlite3_bind_zeroblob(stmt, index, static_cast<int>(num_bytes)));
+    } else {
+        SQLITE3_CALL(sqlite3_bind_blob(stmt, index, data, static_cast<int>(num_bytes),
+                                       SQLITE_STATIC));
+    }
+}
+
+// 把第 column 列的 blob 拷贝到 data，NULL 得到空数组
+template <typename T>
+void ReadBlob(sqlite3_stmt *stmt, int column, std::vector<T> &data) {
+    const T *blob = static_cast<const T *>(sqlite3_column_blob(stmt, column));
+    data.assign(blob, blob + sqlite3_column_bytes(stmt, column) / sizeof(T));
+}
+
+// 绑定主键执行查询，有结果时返回 true，调用方读完列之后需要 reset
+bool StepById(sqlite3_stmt *stmt, int64_t id) {
+    SQLITE3_CALL(sqlite3_bind_int64(stmt, 1, id));
+    if (SQLITE3_CALL(sqlite3_step(stmt)) == SQLITE_ROW) {
+        return true;
+    }
+    SQLITE3_CALL(sqlite3_reset(stmt));
+    return false;
+}
+
+// 把 src 整个复制到 dst
+bool BackupDatabase(sqlite3 *src, sqlite3 *dst) {
+    sqlite3_backup *backup = sqlite3_backup_init(dst, "main", src, "main");
+    if (backup == nullptr) {
+        printf("error sqlite3_backup_init: %s\n", sqlite3_errmsg(dst));
+        return false;
+    }
+    sqlite3_backup_step(backup, -1);
+    return sqlite3_backup_finish(backup) == SQLITE_OK;
+}
+
+}  // namespace
+
+DatabaseWriter::DatabaseWriter()
+    : m_db(nullptr),
+      m_keypoints_stmt(nullptr),
+      m_matches_stmt(nullptr),
+      m_geometries_stmt(nullptr),
+      m_read_keypoints_stmt(nullptr),
+      m_read_matches_stmt(nullptr),
+      m_read_geometries_stmt(nullptr),
+      m_num_rows(0) {}
+
+DatabaseWriter::~DatabaseWriter() {
+    Close();
+}
+
+bool DatabaseWriter::Open(const std::string &path) {
+    Close();
+    if (sqlite3_open_v2(path.c_str(), &m_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX,
+                        nullptr) != SQLITE_OK) {
+        printf("error sqlite3_open %s\n", path.c_str());
+        sqlite3_close(m_db);
+        m_db = nullptr;
+        return false;
+    }
+    // 与 CreateNewSqlTable 相同：不等待落盘，使用 WAL 日志
+    SQLITE3_EXEC(m_db, "PRAGMA synchronous=OFF", nullptr);
+    SQLITE3_EXEC(m_db, "PRAGMA journal_mode=WAL", nullptr);
+    SQLITE3_EXEC(m_db, "PRAGMA temp_store=MEMORY", nullptr);
+
+    SQLITE3_CALL(sqlite3_prepare_v2(
+        m_db, "INSERT OR REPLACE INTO keypoints(image_id, rows, cols, data) VALUES(?, ?, ?, ?);", -1,
+        &m_keypoints_stmt, nullptr));
+    SQLITE3_CALL(sqlite3_prepare_v2(
+        m_db, "INSERT OR REPLACE INTO matches(pair_id, rows, cols, data) VALUES(?, ?, ?, ?);", -1,
+        &m_matches_stmt, nullptr));
+    SQLITE3_CALL(sqlite3_prepare_v2(m_db,
+                                    "INSERT OR REPLACE INTO two_view_geometries(pair_id, rows, cols, data, "
+                                    "config, F, E, H) VALUES(?, ?, ?, ?, ?, ?, ?, ?);",
+                                    -1, &m_geometries_stmt, nullptr));
+    SQLITE3_CALL(sqlite3_prepare_v2(m_db, "SELECT data, cols FROM keypoints WHERE image_id = ?;", -1,
+                                    &m_read_keypoints_stmt, nullptr));
+    SQLITE3_CALL(sqlite3_prepare_v2(m_db, "SELECT data FROM matches WHERE pair_id = ?;", -1,
+                                    &m_read_matches_stmt, nullptr));
+    SQLITE3_CALL(sqlite3_prepare_v2(
+        m_db, "SELECT data, config, F, E, H FROM two_view_geometries WHERE pair_id = ?;", -1,
+        &m_read_geometries_stmt, nullptr));
+    m_num_rows = 0;
+    m_start = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool DatabaseWriter::Create(const std::string &path) {
+    Close();
+    // 旧文件里可能残留 SIFT 特征和其他图像，直接删掉重建
+    for (const char *suffix : {"", "-wal", "-shm"}) {
+        std::remove((path + suffix).c_str());
+    }
+    sqlite3 *db = CreateNewSqlTable(path);
+    sqlite3_close(db);
+    return Open(path);
+}
+
+sqlite3 *DatabaseWriter::LoadTemplate(const std::string &path) {
+    sqlite3 *file_db(nullptr), *memory_db(nullptr);
+    if (sqlite3_open_v2(path.c_str(), &file_db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        printf("error sqlite3_open %s\n", path.c_str());
+        sqlite3_close(file_db);
+        return nullptr;
+    }
+    // 多个线程同时以它为源做备份，使用串行化模式
+    SQLITE3_CALL(sqlite3_open_v2(":memory:", &memory_db,
+                                 SQLITE_OPEN_READWRITE | SQLITE_OPEN_FULLMUTEX, nullptr));
+    bool ok = BackupDatabase(file_db, memory_db);
+    sqlite3_close(file_db);
+    if (!ok) {
+        sqlite3_close(memory_db);
+        return nullptr;
+    }
+    return memory_db;
+}
+
+bool DatabaseWriter::CopyTemplate(sqlite3 *template_db, const std::string &path) {
+    for (const char *suffix : {"", "-wal", "-shm"}) {
+        std::remove((path + suffix).c_str());
+    }
+    sqlite3 *db;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) !=
+        SQLITE_OK) {
+        printf("error sqlite3_open %s\n", path.c_str());
+        sqlite3_close(db);
+        return false;
+    }
+    bool ok = BackupDatabase(template_db, db);
+    sqlite3_close(db);
+    return ok;
+}
+
+void DatabaseWriter::Close() {
+    if (m_db == nullptr) {
+        return;
+    }
+    sqlite3_finalize(m_keypoints_stmt);
+    sqlite3_finalize(m_matches_stmt);
+    sqlite3_finalize(m_geometries_stmt);
+    sqlite3_finalize(m_read_keypoints_stmt);
+    sqlite3_finalize(m_read_matches_stmt);
+    sqlite3_finalize(m_read_geometries_stmt);
+    m_keypoints_stmt = nullptr;
+    m_matches_stmt = nullptr;
+    m_geometries_stmt = nullptr;
+    m_read_keypoints_stmt = nullptr;
+    m_read_matches_stmt = nullptr;
+    m_read_geometries_stmt = nullptr;
+    sqlite3_close(m_db);
+    m_db = nullptr;
+}
+
+void DatabaseWriter::BeginTransaction() {
+    SQLITE3_EXEC(m_db, "BEGIN TRANSACTION;", nullptr);
+}
+
+void DatabaseWriter::Commit() {
+    SQLITE3_EXEC(m_db, "COMMIT;", nullptr);
+}
+
+int DatabaseWriter::WriteCamera(int model, int width, int height, const double *params,
+                                int num_params) {
+    sqlite3_stmt *stmt;
+    SQLITE3_CALL(sqlite3_prepare_v2(m_db,
+                                    "INSERT INTO cameras(model, width, height, params, "
+                                    "prior_focal_length) VALUES(?, ?, ?, ?, ?);",
+                                    -1, &stmt, nullptr));
+    SQLITE3_CALL(sqlite3_bind_int64(stmt, 1, model));
+    SQLITE3_CALL(sqlite3_bind_int64(stmt, 2, width));
+    SQLITE3_CALL(sqlite3_bind_int64(stmt, 3, height));
+    BindBlob(stmt, 4, params, num_params * sizeof(double));
+    SQLITE3_CALL(sqlite3_bind_int64(stmt, 5, 0));  // 焦距是估计值，不作为先验
+    SQLITE3_CALL(sqlite3_step(stmt));
+    SQLITE3_CALL(sqlite3_finalize(stmt));
+    ++m_num_rows;
+    return static_cast<int>(sqlite3_last_insert_rowid(m_db));
+}
+
+void DatabaseWriter::WriteImage(int image_id, const std::string &name, int camera_id) {
+    sqlite3_stmt *stmt;
+    SQLITE3_CALL(sqlite3_prepare_v2(
+        m_db, "INSERT INTO images(image_id, name, camera_id) VALUES(?, ?, ?);", -1, &stmt,
+        nullptr));
+    SQLITE3_CALL(sqlite3_bind_int64(stmt, 1, image_id));
+    SQLITE3_CALL(sqlite3_bind_text(stmt, 2, name.c_str(), static_cast<int>(name.size()),
+                                   SQLITE_STATIC));
+    SQLITE3_CALL(sqlite3_bind_int64(stmt, 3, camera_id));
+    SQLITE3_CALL(sqlite3_step(stmt));
+    SQLITE3_CALL(sqlite3_finalize(stmt));
+    ++m_num_rows;
+}
+
+void DatabaseWriter::ClearFeatures() {
+    SQLITE3_EXEC(m_db, "DELETE FROM keypoints;", nullptr);
+    SQLITE3_EXEC(m_db, "DELETE FROM matches;", nullptr);
+    SQLITE3_EXEC(m_db, "DELETE FROM two_view_geometries;", nullptr);
+}
+
+void DatabaseWriter::WriteKeypoints(int image_id, const void *data, int rows, int cols) {
+    SQLITE3_CALL(sqlite3_bind_int64(m_keypoints_stmt, 1, image_id));
+    SQLITE3_CALL(sqlite3_bind_int64(m_keypoints_stmt, 2, rows));
+    SQLITE3_CALL(sqlite3_bind_int64(m_keypoints_stmt, 3, cols));
+    BindBlob(m_keypoints_stmt, 4, data, rows * cols * sizeof(float));
+    SQLITE3_CALL(sqlite3_step(m_keypoints_stmt));
+    SQLITE3_CALL(sqlite3_reset(m_keypoints_stmt));
+    ++m_num_rows;
+}
+
+void DatabaseWriter::WriteMatches(uint64_t pair_id, const void *data, int rows, int cols) {
+    SQLITE3_CALL(sqlite3_bind_int64(m_matches_stmt, 1, pair_id));
+    SQLITE3_CALL(sqlite3_bind_int64(m_matches_stmt, 2, rows));
+    SQLITE3_CALL(sqlite3_bind_int64(m_matches_stmt, 3, cols));
+    BindBlob(m_matches_stmt, 4, data, rows * cols * sizeof(uint32_t));
+    SQLITE3_CALL(sqlite3_step(m_matches_stmt));
+    SQLITE3_CALL(sqlite3_reset(m_matches_stmt));
+    ++m_num_rows;
+}
+
+void DatabaseWriter::WriteTwoViewGeometry(uint64_t pair_id, const void *data, int rows, int cols,
+                                          int config, const double *F, const double *E,
+                                          const double *H) {
+    SQLITE3_CALL(sqlite3_bind_int64(m_geometries_stmt, 1, pair_id));
+    SQLITE3_CALL(sqlite3_bind_int64(m_geometries_stmt, 2, rows));
+    SQLITE3_CALL(sqlite3_bind_int64(m_geometries_stmt, 3, cols));
+    BindBlob(m_geometries_stmt, 4, data, rows * cols * sizeof(uint32_t));
+    SQLITE3_CALL(sqlite3_bind_int64(m_geometries_stmt, 5, config));
+    BindBlob(m_geometries_stmt, 6, F, F ? 9 * sizeof(double) : 0);
+    BindBlob(m_geometries_stmt, 7, E, E ? 9 * sizeof(double) : 0);
+    BindBlob(m_geometries_stmt, 8, H, H ? 9 * sizeof(double) : 0);
+    SQLITE3_CALL(sqlite3_step(m_geometries_stmt));
+    SQLITE3_CALL(sqlite3_reset(m_geometries_stmt));
+    ++m_num_rows;
+}
+
+bool DatabaseWriter::ReadKeypoints(int image_id, std::vector<float> &data) {
+    data.clear();
+    if (!StepById(m_read_keypoints_stmt, image_id)) {
+        return false;
+    }
+    int cols = sqlite3_column_int(m_read_keypoints_stmt, 1);
+    if (cols < 2) {
+        printf("error: image %d 的 keypoints 有 %d 列，至少需要 x y 两列\n", image_id, cols);
+        SQLITE3_CALL(sqlite3_reset(m_read_keypoints_stmt));
+        return false;
+    }
+    // SIFT 等特征的 keypoints 为 x y 加仿射形状共 4 / 6 列，只取每行的前两列
+    std::vector<float> rows;
+    ReadBlob(m_read_keypoints_stmt, 0, rows);
+    SQLITE3_CALL(sqlite3_reset(m_read_keypoints_stmt));
+    data.reserve(rows.size() / cols * 2);
+    for (size_t k = 0; k + cols <= rows.size(); k += cols) {
+        data.push_back(rows[k]);
+        data.push_back(rows[k + 1]);
+    }
+    return true;
+}
+
+bool DatabaseWriter::ReadMatches(uint64_t pair_id, std::vector<uint32_t> &data) {
+    data.clear();
+    if (!StepById(m_read_matches_stmt, pair_id)) {
+        return false;
+    }
+    ReadBlob(m_read_matches_stmt, 0, data);
+    SQLITE3_CALL(sqlite3_reset(m_read_matches_stmt));
+    return true;
+}
+
+bool DatabaseWriter::ReadTwoViewGeometry(uint64_t pair_id, TwoViewGeometryRow &row) {
+    row = TwoViewGeometryRow();
+    if (!StepById(m_read_geometries_stmt, pair_id)) {
+        return false;
+    }
+    ReadBlob(m_read_geometries_stmt, 0, row.data);
+    row.config = sqlite3_column_int(m_read_geometries_stmt, 1);
+    ReadBlob(m_read_geometries_stmt, 2, row.F);
+    ReadBlob(m_read_geometries_stmt, 3, row.E);
+    ReadBlob(m_read_geometries_stmt, 4, row.H);
+    SQLITE3_CALL(sqlite3_reset(m_read_geometries_stmt));
+    return true;
+}
+
+void DatabaseWriter::PrintStats() const {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    std::cout << "数据库写入 " << m_num_rows << " 行, 耗时 " << seconds << " 秒, "
+              << (seconds > 0 ? m_num_rows / seconds : 0.0) << " 行/秒" << std::endl;
+}
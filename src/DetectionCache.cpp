@@ -0,0 +1,189 @@
+#include "DetectionCache.h"
+
+#include <sys/stat.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const char kCacheMagic[4] = {'S', 'Q', 'D', 'C'};
+const uint32_t kCacheVersion = 1;
+
+template <typename T>
+void WritePod(std::ofstream &fs, const T &value) {
+    fs.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// 从内存缓冲区顺序读取，越界时返回 false
+struct BufferReader
+{
+    const char *ptr;
+    const char *end;
+
+    bool Read(void *dst, size_t size) {
+        if (end - ptr < (std::ptrdiff_t)size) {
+            return false;
+        }
+        memcpy(dst, ptr, size);
+        ptr += size;
+        return true;
+    }
+
+    template <typename T>
+    bool ReadPod(T &value) {
+        return Read(&value, sizeof(T));
+    }
+
+    size_t Remaining() const {
+        return end - ptr;
+    }
+};
+
+}  // namespace
+
+uint64_t Fnv1aHash(const void *data, size_t size, uint64_t seed) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash(seed);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool DetectionCache::Load(const std::string &path) {
+    std::ifstream fs(path, std::ios::binary | std::ios::ate);
+    if (!fs.is_open()) {
+        return false;
+    }
+    std::vector<char> buffer(static_cast<size_t>(fs.tellg()));
+    fs.seekg(0);
+    fs.read(buffer.data(), buffer.size());
+    fs.close();
+
+    BufferReader reader{buffer.data(), buffer.data() + buffer.size()};
+    char magic[4];
+    uint32_t version;
+    uint64_t config_hash, num_entries;
+    if (!reader.Read(magic, 4) || memcmp(magic, kCacheMagic, 4) != 0 ||
+        !reader.ReadPod(version) || version != kCacheVersion || !reader.ReadPod(config_hash) ||
+        !reader.ReadPod(num_entries)) {
+        printf("error detection cache %s format\n", path.c_str());
+        return false;
+    }
+    if (config_hash != m_config_hash) {
+        std::cout << "检测参数已变化，忽略检测缓存 " << path << std::endl;
+        return false;
+    }
+
+    // 长度字段先与剩余字节数比较再分配内存，损坏或截断的文件按未命中处理
+    const size_t kEntryHeader = 2 * sizeof(uint32_t);
+    const size_t kCornerBytes = sizeof(int) + sizeof(cv::Point2f);
+    if (num_entries > reader.Remaining() / kEntryHeader) {
+        printf("error detection cache %s truncated\n", path.c_str());
+        return false;
+    }
+    std::unordered_map<std::string, Entry> entries;
+    entries.reserve(num_entries);
+    for (uint64_t i = 0; i < num_entries; ++i) {
+        uint32_t key_len, num_corners;
+        if (!reader.ReadPod(key_len) || key_len > reader.Remaining()) {
+            printf("error detection cache %s truncated\n", path.c_str());
+            return false;
+        }
+        std::string key(key_len, '\0');
+        if (!reader.Read(&key[0], key_len) || !reader.ReadPod(num_corners) ||
+            num_corners > reader.Remaining() / kCornerBytes) {
+            printf("error detection cache %s truncated\n", path.c_str());
+            return false;
+        }
+        Entry entry;
+        entry.corner_ids.resize(num_corners);
+        entry.corners.resize(num_corners);
+        reader.Read(entry.corner_ids.data(), num_corners * sizeof(int));
+        reader.Read(entry.corners.data(), num_corners * sizeof(cv::Point2f));
+        entries[key] = std::move(entry);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.swap(entries);
+    m_dirty = false;
+    return true;
+}
+
+bool DetectionCache::Save(const std::string &path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_dirty) {
+        return true;
+    }
+    // 先写临时文件再改名，中途退出不会留下损坏的缓存
+    std::string tmp_path(path + ".tmp");
+    std::ofstream fs(tmp_path, std::ios::binary);
+    if (!fs.is_open()) {
+        printf("error open detection cache %s\n", tmp_path.c_str());
+        return false;
+    }
+    fs.write(kCacheMagic, 4);
+    WritePod(fs, kCacheVersion);
+    WritePod(fs, m_config_hash);
+    WritePod(fs, (uint64_t)m_entries.size());
+    for (const auto &element : m_entries) {
+        const Entry &entry = element.second;
+        WritePod(fs, (uint32_t)element.first.size());
+        fs.write(element.first.data(), element.first.size());
+        WritePod(fs, (uint32_t)entry.corner_ids.size());
+        fs.write(reinterpret_cast<const char *>(entry.corner_ids.data()),
+                 entry.corner_ids.size() * sizeof(int));
+        fs.write(reinterpret_cast<const char *>(entry.corners.data()),
+                 entry.corners.size() * sizeof(cv::Point2f));
+    }
+    fs.close();
+    if (!fs || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        printf("error write detection cache %s\n", path.c_str());
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+bool DetectionCache::FileKey(const std::string &file, int frame_id, std::string &key) {
+    struct stat st;
+    if (stat(file.c_str(), &st) != 0) {
+        return false;
+    }
+    key = file + "|" + std::to_string((long long)st.st_size) + "|" +
+          std::to_string((long long)st.st_mtim.tv_sec) + "." +
+          std::to_string((long long)st.st_mtim.tv_nsec);
+    if (frame_id >= 0) {
+        key += "#" + std::to_string(frame_id);
+    }
+    return true;
+}
+
+bool DetectionCache::Lookup(const std::string &key, std::vector<int> &corner_ids,
+                            std::vector<cv::Point2f> &corners) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    corner_ids = it->second.corner_ids;
+    corners = it->second.corners;
+    return true;
+}
+
+void DetectionCache::Insert(const std::string &key, const std::vector<int> &corner_ids,
+                            const std::vector<cv::Point2f> &corners) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry &entry = m_entries[key];
+    entry.corner_ids = corner_ids;
+    entry.corners = corners;
+    m_dirty = true;
+}
+
+size_t DetectionCache::Size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
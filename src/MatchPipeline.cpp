@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "BoundedQueue.h"
+#include "Matcher.h"
+
+namespace {
+
+// 读图线程 -> 检测线程
+struct ImageTask
+{
+    int task = -1;  // group_idx * cam_num + cam_id
+    Mat img;
+    string cache_key;
+};
+
+// 检测线程 -> 保存线程
+struct DetectResult
+{
+    int task = -1;
+    double detect_ms = 0.0;
+    bool cached = false;  // 读图线程直接从缓存得到的结果
+    string cache_key;
+    vector<int> marker_ids;
+    vector<Point2f> marker_corners;
+};
+
+}  // namespace
+
+/**
+ * @brief 读图 / 检测 / 保存 三级流水线
+ *
+ * io_threads 个线程负责读图（或视频帧）和解码，detect_threads 个线程负责 ChArUco 检测，
+ * 调用线程负责保存检测结果，各级之间用定长无锁队列连接，
+ * 读盘和解码不再阻塞检测。
+ *
+ * @return 所有图像检测耗时之和（毫秒）
+ */
+double Matcher::MatchPipelined(const CharucoDetector &detector,
+                               const vector<string> &image_names, int group_num, int cam_num,
+                               int cam_start, int group_start) {
+    int task_num(group_num * cam_num);
+    bool is_video(!m_options.video_path.empty());
+    int io_threads(std::max(1, m_options.io_threads));
+    if (is_video) { // 每个视频只能顺序解码，读图线程按相机划分
+        io_threads = std::min(io_threads, cam_num);
+    }
+    int detect_threads(m_options.detect_threads);
+    if (detect_threads <= 0) {
+        detect_threads = std::max(1, (int)std::thread::hardware_concurrency() - io_threads);
+    }
+    cout << "流水线: " << io_threads << " 个读图线程, " << detect_threads << " 个检测线程" << endl;
+
+    BoundedQueue<ImageTask> image_queue(m_options.queue_size);
+    BoundedQueue<DetectResult> result_queue(m_options.queue_size);
+    std::atomic<int> next_task(0);
+    std::atomic<int> io_running(io_threads);
+    std::atomic<int> detect_running(detect_threads);
+
+    // 命中检测缓存时读图线程直接把结果交给保存线程，跳过读图和检测。
+    // 读图线程全部结束之后检测线程才会结束，所以保存线程仍然能取到这些结果
+    auto CacheToResult = [&](const ImageTask &item, BoundedQueue<DetectResult> &queue) {
+        DetectResult result;
+        if (!m_cache->Lookup(item.cache_key, result.marker_ids, result.marker_corners)) {
+            return false;
+        }
+        result.task = item.task;
+        result.cached = true;
+        queue.Push(result);
+        return true;
+    };
+
+    // 1. 读图解码
+    auto io_worker = [&]() {
+        for (int task = next_task++; task < task_num; task = next_task++) {
+            const string &image_name = image_names[task];
+            ImageTask item;
+            item.task = task;
+            if (m_cache && DetectionCache::FileKey(image_name, -1, item.cache_key) &&
+                CacheToResult(item, result_queue)) {
+                continue;
+            }
+            item.img = imread(image_name, 0);
+            image_queue.Push(item);
+        }
+        io_running.fetch_sub(1, std::memory_order_release);
+    };
+
+    // 1'. 视频解码：线程 tid 负责 cam_id % io_threads == tid 的相机，逐组顺序读帧
+    auto video_worker = [&](int tid) {
+        vector<int> cams;
+        vector<string> video_names;
+        vector<std::unique_ptr<VideoCapture>> captures;
+        for (int cam_id = tid; cam_id < cam_num; cam_id += io_threads) {
+            boost::format fmt(m_options.video_path);
+            string video_name = (fmt % (cam_id + cam_start)).str();
+            cams.push_back(cam_id);
+            video_names.push_back(video_name);
+            captures.emplace_back(new VideoCapture(video_name));
+            VideoCapture &cap = *captures.back();
+            if (!cap.isOpened()) {
+                printf("error open video %s\n", video_name.c_str());
+                continue;
+            }
+            // 第 group_id 组对应每个视频的第 group_id 帧，不支持定位时逐帧跳过
+            if (group_start > 0 && !cap.set(CAP_PROP_POS_FRAMES, group_start)) {
+                int skipped(0);
+                while (skipped < group_start && cap.grab()) {
+                    ++skipped;
+                }
+            }
+        }
+        Mat frame;
+        for (int group_idx = 0; group_idx < group_num; ++group_idx) {
+            for (int k = 0; k < cams.size(); ++k) {
+                ImageTask item;
+                item.task = group_idx * cam_num + cams[k];
+                if (m_cache &&
+                    DetectionCache::FileKey(video_names[k], group_start + group_idx, item.cache_key) &&
+                    CacheToResult(item, result_queue)) {
+                    captures[k]->grab(); // 命中缓存的帧只前进不解码
+                    continue;
+                }
+                if (captures[k]->isOpened() && captures[k]->read(frame) && !frame.empty()) {
+                    if (frame.channels() == 1) {
+                        item.img = frame.clone();
+                    } else {
+                        cvtColor(frame, item.img, COLOR_BGR2GRAY);
+                    }
+                }
+                image_queue.Push(item);
+            }
+        }
+        io_running.fetch_sub(1, std::memory_order_release);
+    };
+
+    // 2. 检测
+    auto detect_worker = [&]() {
+        ImageTask item;
+        while (image_queue.Pop(item, io_running)) {
+            DetectResult result;
+            result.task = item.task;
+            result.cache_key = std::move(item.cache_key);
+            result.detect_ms =
+                DetectImage(detector, item.task / cam_num, item.task % cam_num, item.img,
+                            result.marker_ids, result.marker_corners);
+            item.img.release();
+            result_queue.Push(result);
+        }
+        detect_running.fetch_sub(1, std::memory_order_release);
+    };
+
+    vector<std::thread> workers;
+    for (int i = 0; i < io_threads; ++i) {
+        if (is_video) {
+            workers.emplace_back(video_worker, i);
+        } else {
+            workers.emplace_back(io_worker);
+        }
+    }
+    for (int i = 0; i < detect_threads; ++i) {
+        workers.emplace_back(detect_worker);
+    }
+
+    // 3. 保存结果，只有当前线程写 m_views
+    double detect_ms(0.0);
+    DetectResult result;
+    while (result_queue.Pop(result, detect_running)) {
+        detect_ms += result.detect_ms;
+        if (result.cached) {
+            ++m_cache_hits;
+        } else if (m_cache && !result.cache_key.empty()) {
+            m_cache->Insert(result.cache_key, result.marker_ids, result.marker_corners);
+        }
+        StoreDetection(result.task / cam_num, result.task % cam_num, std::move(result.marker_ids),
+                       std::move(result.marker_corners));
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    return detect_ms;
+}
@@ -1,79 +1,291 @@
+#include <omp.h>
+
 #include "Matcher.h"
 
+// 标定板和检测参数的指纹，任何一项变化都会使检测缓存失效
+static uint64_t DetectConfigHash(const CharucoBoardSpec &spec, const MatchOptions &options) {
+    const int kDetectorVersion = 1; // 修改检测流程（如亚像素迭代规则）时递增
+    uint64_t hash = Fnv1aHash(&kDetectorVersion, sizeof(kDetectorVersion));
+    hash = Fnv1aHash(&spec.squares_x, sizeof(spec.squares_x), hash);
+    hash = Fnv1aHash(&spec.squares_y, sizeof(spec.squares_y), hash);
+    hash = Fnv1aHash(&spec.square_length, sizeof(spec.square_length), hash);
+    hash = Fnv1aHash(&spec.marker_length, sizeof(spec.marker_length), hash);
+    hash = Fnv1aHash(&spec.dictionary, sizeof(spec.dictionary), hash);
+    hash = Fnv1aHash(&options.pyramid_level, sizeof(options.pyramid_level), hash);
+    hash = Fnv1aHash(&options.roi_tracking, sizeof(options.roi_tracking), hash);
+    hash = Fnv1aHash(&options.roi_padding, sizeof(options.roi_padding), hash);
+    return hash;
+}
+
+// SplitMix64，把种子和随机数流编号混合成互不相关的种子
+static uint64_t SplitMix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+std::string ViewName(const std::string &image_path, int group_id, int cam_id) {
+    if (image_path.empty()) {
+        return (boost::format("%04d.png") % cam_id).str();
+    }
+    string image_name = (boost::format(image_path) % group_id % cam_id).str();
+    return image_name.substr(image_name.find_last_of('/') + 1);
+}
 
 /**
  * @brief 提取每组图像的 ArUco 角点坐标，并建立匹配关系
  * 
- * @param image_path 图像路径，%d/%04d.jpg or png 格式
+ * @param image_path 图像路径，%d/%04d.jpg or png 格式；设置了 m_options.video_path 时不使用
  * @param group_num 图像组数
  * @param cam_num 相机数量
- * @param jpg2Cam 图像名称和相机 ID 的对应关系，比如 0000.jpg or png 对应 1 号相机
+ * @param jpg2Cam 图像名称和视图 ID 的对应关系，比如 0000.jpg or png 对应 0 号视图，开始检测前一次性解析
  * @param cam_start 相机 ID 的起始基准
  * @param group_start 图像组数的起始基准
  */
 void Matcher::Match(const std::string &image_path, int group_num, int cam_num,
-                    unordered_map<string, int> &jpg2Cam, int cam_start, int group_start) {
-    // ! 根据标定板修改
-    int markers_num(81);
-    MatchData tmp_match_data(cam_num);
-    m_match_data.resize(group_num * markers_num, tmp_match_data);
-
-    // 建立角点亚像素化迭代规则
-    TermCriteria criteria = TermCriteria(TermCriteria::EPS + TermCriteria::MAX_ITER, 40, 0.001);
-
-#pragma omp parallel for
-    for (int group_id = group_start; group_id < group_start + group_num; ++group_id) {
-        for (int cam_id = 0; cam_id < cam_num; ++cam_id) {
-            // 1. 读图
-            boost::format fmt(image_path);
-            string image_name = (fmt % group_id % (cam_id + cam_start)).str();
-            Mat img = imread(image_name, 0);
-
-            // 2. 检测
-            Ptr<aruco::Dictionary> dictionary =
-                cv::aruco::getPredefinedDictionary(cv::aruco::DICT_7X7_50);
-            cv::Ptr<cv::aruco::CharucoBoard> board =
-                cv::aruco::CharucoBoard::create(10, 10, 0.1f, 0.078f, dictionary); // ! 根据 ArUco 码的实际尺寸进行修改
-            cv::Ptr<cv::aruco::DetectorParameters> params = cv::aruco::DetectorParameters::create();
-
-            vector<int> aruco_ids;
-            vector<vector<Point2f>> aruco_corners;
-            aruco::detectMarkers(img, board->dictionary, aruco_corners, aruco_ids, params);
-            // ! 如果是 OpenCV4 或更高版本，可能要改成下面这个写法
-            // aruco::detectMarkers(img, board->getDictionary(), aruco_corners, aruco_ids, params);
-
-            std::vector<cv::Point2f> marker_corners; // 角点 UV 坐标
-            std::vector<int> marker_ids;
-            if (aruco_ids.size() > 0) { // 检测到 ArUco
-                cv::aruco::interpolateCornersCharuco(aruco_corners, aruco_ids, img, board,
-                                                     marker_corners, marker_ids);
-                if (marker_ids.size() > 0) { // 检测到 ArUco 的角点，一般是 4 个点
-                    cornerSubPix(img, marker_corners, Size(5, 5), Size(-1, -1), criteria);
-
-                    // 3. 保存结果
-                    // char cam_char[50];
-                    // sprintf(cam_char, "%04d.png", cam_id);
-                    boost::format fmt("%04d.png"); // ! change this as you need !
-                    int real_cam_id = jpg2Cam[(fmt % cam_id).str()];  // 查找真实图像的视角id
-                    for (int cnt = 0; cnt < marker_ids.size(); ++cnt) {
-                        m_match_data[group_id * markers_num + marker_ids[cnt]].FillData(
-                            real_cam_id, marker_corners[cnt].x, marker_corners[cnt].y);
-                    }
+                    const unordered_map<string, int> &jpg2Cam, int cam_start, int group_start) {
+    // 检测上下文只构建一次，所有线程只读共享
+    CharucoDetector detector(m_board_spec);
+    int markers_num(m_board_spec.NumCorners());
+    m_match_data.Reset(cam_num);
+    m_views.assign(group_num * cam_num, ViewDetection());
+
+    // 相机序号 -> 视图 ID 和所有图像路径只解析一次，检测循环中不再格式化字符串、查哈希表
+    m_view_ids.assign(cam_num, -1);
+    for (int cam_id = 0; cam_id < cam_num; ++cam_id) {
+        string name = ViewName(image_path, group_start, cam_id + cam_start);
+        auto it = jpg2Cam.find(name);
+        if (it == jpg2Cam.end() || it->second < 0 || it->second >= cam_num) {
+            printf("error: 数据库中没有图像 %s，丢弃相机 %d 的检测结果\n", name.c_str(),
+                   cam_id + cam_start);
+            continue;
+        }
+        m_view_ids[cam_id] = it->second;
+    }
+    vector<string> image_names;
+    if (m_options.video_path.empty()) {
+        image_names.resize(group_num * cam_num);
+        for (int group_idx = 0; group_idx < group_num; ++group_idx) {
+            for (int cam_id = 0; cam_id < cam_num; ++cam_id) {
+                image_names[group_idx * cam_num + cam_id] =
+                    (boost::format(image_path) % (group_start + group_idx) % (cam_id + cam_start))
+                        .str();
+            }
+        }
+    }
+
+    // 分块调用时每块的 group_idx 都从 0 开始，上一块的跟踪状态不能沿用
+    m_track_roi.assign(cam_num, TrackedRoi());
+    m_roi_hits = 0;
+    m_roi_misses = 0;
+
+    // 载入上次运行的检测结果，分块调用时只在第一次载入
+    m_cache_hits = 0;
+    if (!m_options.cache_path.empty() && !m_cache) {
+        m_cache.reset(new DetectionCache(DetectConfigHash(m_board_spec, m_options)));
+        if (m_cache->Load(m_options.cache_path)) {
+            cout << "载入检测缓存 " << m_cache->Size() << " 条" << endl;
+        }
+    }
+
+    // 单张图像检测耗时统计
+    double detect_ms(0.0);
+
+    if (m_options.io_threads > 0 || !m_options.video_path.empty()) {
+        detect_ms = MatchPipelined(detector, image_names, group_num, cam_num, cam_start,
+                                   group_start);
+    } else {
+        // (组, 相机) 展开为 group_num * cam_num 个独立任务动态调度，
+        // 组数较少或者各图像检测耗时不均时，线程也不会在尾部空等
+#pragma omp parallel for collapse(2) schedule(dynamic, 1) reduction(+ : detect_ms)
+        for (int group_idx = 0; group_idx < group_num; ++group_idx) {
+            for (int cam_id = 0; cam_id < cam_num; ++cam_id) {
+                // 1. 读图
+                const string &image_name = image_names[group_idx * cam_num + cam_id];
+                std::vector<cv::Point2f> marker_corners; // 角点 UV 坐标
+                std::vector<int> marker_ids;
+                string cache_key;
+                if (m_cache && DetectionCache::FileKey(image_name, -1, cache_key) &&
+                    m_cache->Lookup(cache_key, marker_ids, marker_corners)) { // 命中缓存，跳过读图和检测
+                    ++m_cache_hits;
+                    StoreDetection(group_idx, cam_id, std::move(marker_ids),
+                                   std::move(marker_corners));
+                    continue;
+                }
+                Mat img = imread(image_name, 0);
+
+                // 2. 检测
+                detect_ms += DetectImage(detector, group_idx, cam_id, img, marker_ids,
+                                         marker_corners);
+                if (m_cache && !cache_key.empty()) {
+                    m_cache->Insert(cache_key, marker_ids, marker_corners);
                 }
+
+                // 3. 保存结果
+                StoreDetection(group_idx, cam_id, std::move(marker_ids),
+                               std::move(marker_corners));
             }
         }
     }
+    int detect_count(group_num * cam_num - m_cache_hits);
+    if (detect_count > 0) {
+        cout << "单张图像平均检测耗时: " << detect_ms / detect_count << " ms ("
+             << detect_count << " 张)" << endl;
+    }
+    if (m_options.pyramid_report) {
+        m_pyramid_report.Print();
+    }
+    if (m_options.roi_tracking) {
+        cout << "ROI 跟踪: 命中 " << m_roi_hits << " 次, 回退全图检测 " << m_roi_misses << " 次"
+             << endl;
+    }
+    if (m_cache) {
+        cout << "检测缓存: 命中 " << m_cache_hits << " 张" << endl;
+    }
 
-    // ! Log File
-    ofstream fs("./log.txt");
-    for (auto i : m_match_data) {
-        for (auto j : i.pixel_points) {
-            fs << "(" << j.first << ", " << j.second << ")"
-            << " | ";
+    // 汇总成轨迹
+    auto build_start = chrono::steady_clock::now();
+    BuildTracks(group_num, cam_num);
+    m_match_data.PrintStats("轨迹",
+        chrono::duration<double, milli>(chrono::steady_clock::now() - build_start).count());
+
+    // ! Log File: 只保存有效观测的二进制文件，见 Observations.h
+    if (m_options.observations_path.empty()) {
+        return;
+    }
+    ObservationFile obs_file;
+    obs_file.cam_num = cam_num;
+    obs_file.track_offset = (uint64_t)group_start * markers_num;
+    obs_file.num_tracks = m_match_data.NumTracks();
+    obs_file.observations.reserve(m_match_data.NumObservations());
+    for (uint32_t track_id = 0; track_id < m_match_data.NumTracks(); ++track_id) {
+        for (uint32_t k = m_match_data.Begin(track_id); k < m_match_data.End(track_id); ++k) {
+            obs_file.observations.push_back(
+                {track_id, m_match_data.m_cam_ids[k], m_match_data.m_u[k], m_match_data.m_v[k]});
         }
-        fs << endl;
     }
-    fs.close();
+    WriteObservations(m_options.observations_path, obs_file);
+}
+
+void Matcher::SaveDetectionCache() {
+    if (m_cache) {
+        m_cache->Save(m_options.cache_path);
+    }
+}
+
+double Matcher::DetectImage(const CharucoDetector &detector, int group_idx, int cam_id,
+                            const Mat &img, vector<int> &marker_ids,
+                            vector<Point2f> &marker_corners) {
+    auto detect_start = chrono::steady_clock::now();
+
+    // 1. 在上一组标定板位置附近搜索
+    bool tracked(false);
+    if (m_options.roi_tracking) {
+        TrackedRoi prev;
+        {
+            std::lock_guard<std::mutex> lock(m_roi_mutex);
+            prev = m_track_roi[cam_id];
+        }
+        if (prev.group_idx >= 0) {
+            int pad = static_cast<int>(m_options.roi_padding *
+                                       std::max(prev.box.width, prev.box.height));
+            Rect search(prev.box.x - pad, prev.box.y - pad, prev.box.width + 2 * pad,
+                        prev.box.height + 2 * pad);
+            int found = detector.Detect(img, marker_ids, marker_corners, m_options.pyramid_level,
+                                        search);
+            // 角点数骤减说明标定板可能移出了搜索区域，同样按未命中处理
+            tracked = found > 0 && 2 * found >= prev.num_corners;
+            if (tracked) {
+                ++m_roi_hits;
+            } else {
+                ++m_roi_misses;
+            }
+        }
+    }
+
+    // 2. 全图检测
+    if (!tracked) {
+        detector.Detect(img, marker_ids, marker_corners, m_options.pyramid_level);
+    }
+
+    // 3. 更新跟踪状态，乱序完成时只保留最新一组的结果
+    if (m_options.roi_tracking && !marker_ids.empty()) {
+        std::lock_guard<std::mutex> lock(m_roi_mutex);
+        TrackedRoi &roi = m_track_roi[cam_id];
+        if (group_idx >= roi.group_idx) {
+            roi.group_idx = group_idx;
+            roi.num_corners = marker_ids.size();
+            roi.box = boundingRect(marker_corners);
+        }
+    }
+    double detect_ms =
+        chrono::duration<double, milli>(chrono::steady_clock::now() - detect_start).count();
+
+    if (m_options.pyramid_report && m_options.pyramid_level > 0) {
+        // 对照组：全分辨率检测
+        vector<int> full_ids;
+        vector<Point2f> full_corners;
+        auto full_start = chrono::steady_clock::now();
+        detector.Detect(img, full_ids, full_corners, 0);
+        double full_ms =
+            chrono::duration<double, milli>(chrono::steady_clock::now() - full_start).count();
+        std::lock_guard<std::mutex> lock(m_report_mutex);
+        m_pyramid_report.Add(marker_ids, marker_corners, detect_ms, full_ids, full_corners, full_ms);
+    }
+    return detect_ms;
+}
+
+void Matcher::StoreDetection(int group_idx, int cam_id, vector<int> marker_ids,
+                             vector<Point2f> marker_corners) {
+    int real_cam_id = m_view_ids[cam_id];  // 真实图像的视角id
+    if (marker_ids.empty() || real_cam_id < 0) { // 未检测到 ArUco 的角点，或数据库中没有该图像
+        return;
+    }
+    int cam_num(m_match_data.m_cam_num);
+    ViewDetection &view = m_views[group_idx * cam_num + real_cam_id];
+    view.marker_ids = std::move(marker_ids);
+    view.marker_corners = std::move(marker_corners);
+}
+
+void Matcher::BuildTracks(int group_num, int cam_num) {
+    int markers_num(m_board_spec.NumCorners());
+    size_t num_obs(0);
+    for (const auto &view : m_views) {
+        num_obs += view.marker_ids.size();
+    }
+    m_match_data.Reset(cam_num);
+    m_match_data.Reserve((size_t)group_num * markers_num, num_obs);
+    m_match_data.m_cam_ids.resize(num_obs);
+    m_match_data.m_u.resize(num_obs);
+    m_match_data.m_v.resize(num_obs);
+
+    // 每组先统计各角点的观测数得到偏移，再按视图升序填入，轨迹内相机 id 自然有序
+    vector<uint32_t> cursor(markers_num);
+    for (int group_idx = 0; group_idx < group_num; ++group_idx) {
+        const ViewDetection *views = &m_views[group_idx * cam_num];
+        std::fill(cursor.begin(), cursor.end(), 0);
+        for (int view_id = 0; view_id < cam_num; ++view_id) {
+            for (int marker_id : views[view_id].marker_ids) {
+                ++cursor[marker_id];
+            }
+        }
+        for (int marker_id = 0; marker_id < markers_num; ++marker_id) {
+            uint32_t begin = m_match_data.m_offsets.back();
+            m_match_data.m_offsets.push_back(begin + cursor[marker_id]);
+            cursor[marker_id] = begin;
+        }
+        for (int view_id = 0; view_id < cam_num; ++view_id) {
+            const ViewDetection &view = views[view_id];
+            for (int cnt = 0; cnt < view.marker_ids.size(); ++cnt) {
+                uint32_t k = cursor[view.marker_ids[cnt]]++;
+                m_match_data.m_cam_ids[k] = view_id;
+                m_match_data.m_u[k] = view.marker_corners[cnt].x;
+                m_match_data.m_v[k] = view.marker_corners[cnt].y;
+            }
+        }
+    }
+    std::vector<ViewDetection>().swap(m_views);
 }
 
 void CreateIdMap(const std::string &db_path, std::unordered_map<std::string, int> &cam_id,
@@ -108,145 +320,416 @@ void CreateIdMap(const std::string &db_path, std::unordered_map<std::string, int
     }
 }
 
+bool CreateDatabase(const std::string &db_path, const std::string &image_path, int cam_num,
+                    int cam_start, int group_start, const std::string &camera_model,
+                    std::unordered_map<std::string, int> &cam_id,
+                    std::unordered_map<int, std::string> &cam_name) {
+    // COLMAP 相机模型的编号和参数个数
+    static const std::map<std::string, std::pair<int, int>> models{
+        {"SIMPLE_PINHOLE", {0, 3}}, {"PINHOLE", {1, 4}}, {"SIMPLE_RADIAL", {2, 4}},
+        {"RADIAL", {3, 5}},         {"OPENCV", {4, 8}}};
+    auto model = models.find(camera_model);
+    if (model == models.end()) {
+        printf("error unsupported camera model %s\n", camera_model.c_str());
+        return false;
+    }
+
+    DatabaseWriter writer;
+    if (!writer.Create(db_path)) {
+        return false;
+    }
+    writer.BeginTransaction();
+    for (int cam = 0; cam < cam_num; ++cam) {
+        std::string image_name, name(ViewName(image_path, group_start, cam + cam_start));
+        if (!image_path.empty()) {
+            image_name = (boost::format(image_path) % group_start % (cam + cam_start)).str();
+        }
+        int width(1920), height(1080);
+        if (!image_name.empty() && !ReadImageSize(image_name, width, height)) {
+            printf("warning: 无法读取 %s 的尺寸，使用 %dx%d\n", image_name.c_str(), width, height);
+        }
+        // 与 COLMAP feature_extractor 相同：焦距取 1.2 倍长边，主点在图像中心，畸变为 0
+        double focal = 1.2 * std::max(width, height);
+        double cx = width / 2.0, cy = height / 2.0;
+        std::vector<double> params;
+        switch (model->second.first) {
+            case 0:
+            case 2:
+            case 3:
+                params = {focal, cx, cy};
+                break;
+            default:
+                params = {focal, focal, cx, cy};
+                break;
+        }
+        params.resize(model->second.second, 0.0);
+        int camera_id = writer.WriteCamera(model->second.first, width, height, params.data(),
+                                           params.size());
+        writer.WriteImage(cam + 1, name, camera_id);
+        cam_id[name] = cam;
+        cam_name[cam + 1] = name;
+    }
+    writer.Commit();
+    writer.PrintStats();
+    return true;
+}
+
+namespace {
+
+// 一个相机对的几何校验结果
+struct PairGeometry
+{
+    bool valid = false;
+    Eigen::Matrix3d F;
+    std::vector<std::pair<int, int>> inliers;
+    double time_ms = 0.0;
+};
+
+/**
+ * @brief 对所有相机对并行做 RANSAC 基础矩阵估计，只保留内点
+ *
+ * @param geometries 输出，geometries[i * num_cam + j] 为相机 i 和 j（i < j）的结果
+ */
+void VerifyPairs(const std::vector<Camera> &cameras, const VerifyOptions &options,
+                 std::vector<PairGeometry> &geometries) {
+    int num_cam(cameras.size());
+    geometries.assign(num_cam * num_cam, PairGeometry());
+    auto verify_start = std::chrono::steady_clock::now();
+#pragma omp parallel for schedule(dynamic)
+    for (int pair = 0; pair < num_cam * num_cam; ++pair) {
+        int i = pair / num_cam;
+        int j = pair % num_cam;
+        const auto &matches = cameras[i].m_matches[j];
+        if (j <= i || matches.empty()) {
+            continue;
+        }
+        auto pair_start = std::chrono::steady_clock::now();
+        std::vector<Eigen::Vector2d> pts1(matches.size()), pts2(matches.size());
+        for (int k = 0; k < matches.size(); ++k) {
+            const auto &p1 = cameras[i].m_keypoints[matches[k].first];
+            const auto &p2 = cameras[j].m_keypoints[matches[k].second];
+            pts1[k] = Eigen::Vector2d(p1.first, p1.second);
+            pts2[k] = Eigen::Vector2d(p2.first, p2.second);
+        }
+        PairGeometry &geometry = geometries[pair];
+        std::vector<char> inlier_mask;
+        int num_inliers = EstimateFundamentalRansac(pts1, pts2, options, pair, geometry.F,
+                                                    inlier_mask);
+        if (num_inliers >= options.min_inliers) {
+            geometry.valid = true;
+            geometry.inliers.reserve(num_inliers);
+            for (int k = 0; k < matches.size(); ++k) {
+                if (inlier_mask[k]) {
+                    geometry.inliers.push_back(matches[k]);
+                }
+            }
+        }
+        geometry.time_ms = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - pair_start).count();
+    }
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                                verify_start).count();
+
+    // 逐对输出内点率和耗时
+    size_t num_matches(0), num_inliers(0);
+    int num_valid(0), num_pairs(0);
+    for (int i = 0; i < num_cam; ++i) {
+        for (int j = i + 1; j < num_cam; ++j) {
+            const PairGeometry &geometry = geometries[i * num_cam + j];
+            size_t n = cameras[i].m_matches[j].size();
+            if (n == 0) {
+                continue;
+            }
+            ++num_pairs;
+            num_matches += n;
+            num_inliers += geometry.inliers.size();
+            num_valid += geometry.valid;
+            printf("校验 %d-%d: 匹配 %zu, 内点率 %.3f, 耗时 %.2f ms%s\n", i, j, n,
+                   double(geometry.inliers.size()) / n, geometry.time_ms,
+                   geometry.valid ? "" : " (丢弃)");
+        }
+    }
+    printf("几何校验: %d/%d 个相机对通过, 总内点率 %.3f, 耗时 %.1f ms\n", num_valid, num_pairs,
+           num_matches > 0 ? double(num_inliers) / num_matches : 0.0, total_ms);
+}
+
+// 把数据库中 rows x 2 的 uint32 匹配转换成 (特征点 id, 特征点 id) 对
+void AssignPairs(const std::vector<uint32_t> &data, std::vector<std::pair<int, int>> &pairs) {
+    pairs.resize(data.size() / 2);
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        pairs[k] = {(int)data[2 * k], (int)data[2 * k + 1]};
+    }
+}
+
+}  // namespace
+
 void ExtractToDatabase(int num_cam, const std::string &db_path, const std::string &txt_path,
-                       const std::vector<MatchData> &data,
-                       std::unordered_map<int, std::string> &cam_name) {
+                       const TrackStore &data,
+                       std::unordered_map<int, std::string> &cam_name,
+                       const ExportOptions &options) {
     // 预处理Camera对象
     std::vector<Camera> cameras(num_cam, Camera(-1, num_cam));
-    std::vector<int> point_ids(num_cam, 0);
     for (int i = 0; i < num_cam; ++i) {
         cameras[i].SetId(i + 1);
+        cameras[i].m_keypoints.reserve(data.NumObservations() / std::max(num_cam, 1));
     }
-    int num_all(data.size());  // 12*4
+    int num_all(data.NumTracks());  // 12*4
     std::cout << "num all: " << num_all << std::endl;
-    for (int i = 0; i < num_all; ++i) {
-        // 存储当前点在各个视图中的id
-        std::vector<int> id(num_cam, -1);
-        for (int cam_id = 0; cam_id < num_cam; ++cam_id) {
-            // 当前视图不可见
-            if (data[i].pixel_points[cam_id].first < 0) {
-                continue;
+
+    // 0 打开数据库文件，所有写入放在一个事务中
+    DatabaseWriter writer;
+    if (!writer.Open(db_path)) {
+        return;
+    }
+    // 追加模式：先放入已有的特征点，新特征点的 id 接在后面
+    if (options.append) {
+        std::vector<float> old_keypoints;
+        for (int i = 0; i < num_cam; ++i) {
+            writer.ReadKeypoints(cameras[i].GetId(), old_keypoints);
+            cameras[i].m_keypoints.reserve(cameras[i].m_keypoints.capacity() +
+                                           old_keypoints.size() / 2);
+            for (size_t k = 0; k + 1 < old_keypoints.size(); k += 2) {
+                cameras[i].AddKeypoint({old_keypoints[k], old_keypoints[k + 1]});
             }
-            std::pair<float, float> pixel_coord = data[i].pixel_points[cam_id];
-            bool insert_ok = cameras[cam_id].AddKeypoints(pixel_coord, point_ids[cam_id]);
-            if (insert_ok) {
-                id[cam_id] = point_ids[cam_id];
-                ++point_ids[cam_id];
-            } else {
-                // std::cout << cam_id << std::endl;
-                id[cam_id] = cameras[cam_id].PointId(pixel_coord);
+        }
+    }
+    // obs_kp[k] 为第 k 个观测在其视图中的特征点 id
+    std::vector<int> obs_kp(data.NumObservations());
+    for (uint32_t k = 0; k < obs_kp.size(); ++k) {
+        int cam_id = data.m_cam_ids[k];
+        obs_kp[k] = cameras[cam_id].AddKeypoint({data.m_u[k], data.m_v[k]});
+    }
+
+    // 只为每条轨迹中真正共视的相机对生成匹配：轨迹分成连续的若干段，每段写入自己的缓冲区，
+    // 再按相机对并行、按段的顺序拼接，结果与串行生成完全一致
+    auto match_start = std::chrono::steady_clock::now();
+    int num_chunks = omp_get_max_threads();
+    std::vector<std::vector<std::vector<std::pair<int, int>>>> chunk_matches(num_chunks);
+#pragma omp parallel for schedule(static, 1)
+    for (int chunk = 0; chunk < num_chunks; ++chunk) {
+        auto &local = chunk_matches[chunk];
+        local.resize(num_cam * num_cam);
+        int track_begin = (int64_t)num_all * chunk / num_chunks;
+        int track_end = (int64_t)num_all * (chunk + 1) / num_chunks;
+        for (int i = track_begin; i < track_end; ++i) {
+            for (uint32_t a = data.Begin(i); a < data.End(i); ++a) {
+                for (uint32_t b = a + 1; b < data.End(i); ++b) { // 轨迹内相机 id 升序
+                    local[data.m_cam_ids[a] * num_cam + data.m_cam_ids[b]].push_back(
+                        {obs_kp[a], obs_kp[b]});
+                }
             }
         }
-        for (int cam_id = 0; cam_id < num_cam; ++cam_id) {
-            cameras[cam_id].AddMatches(id);
+    }
+#pragma omp parallel for schedule(dynamic)
+    for (int pair = 0; pair < num_cam * num_cam; ++pair) {
+        int i = pair / num_cam;
+        int j = pair % num_cam;
+        if (j <= i) {
+            continue;
+        }
+        size_t num_match(0);
+        for (const auto &local : chunk_matches) {
+            num_match += local[pair].size();
+        }
+        auto &matches = cameras[i].m_matches[j];
+        matches.reserve(num_match);
+        for (auto &local : chunk_matches) {
+            matches.insert(matches.end(), local[pair].begin(), local[pair].end());
+            std::vector<std::pair<int, int>>().swap(local[pair]);
         }
-        std::vector<int>().swap(id);
     }
+    std::cout << "生成匹配耗时: "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                           match_start).count()
+              << " ms" << std::endl;
     for (int i = 0; i < num_cam; ++i) {
         std::cout << "m_keypoints: " << i << " " << cameras[i].m_keypoints.size() << std::endl;
     }
 
-    sqlite3 *db;
-    sqlite3_stmt *stmt = NULL;
-    const char *z_tail;
-    char *err_msg;
-    // 0 打开数据库文件
-    int rc = sqlite3_open(db_path.c_str(), &db);
-    if (rc != SQLITE_OK) {
-        printf("error sqlite3_open\n");
-        return;
+    // 对每个相机对做几何校验，剔除误检角点造成的外点
+    std::vector<PairGeometry> geometries;
+    if (options.verify) {
+        VerifyPairs(cameras, options.verify_options, geometries);
     }
-    // 2 删除原始keypoint记录
-    if (sqlite3_prepare_v2(db, "DELETE FROM keypoints;", -1, &stmt, &z_tail) != SQLITE_OK) {
-        printf("error DELETE FROM keypoints\n");
-        return;
-    }
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        printf("error DELETE FROM keypoints\n");
-        return;
-    }
-    // 3 删除原始matches记录
-    if (sqlite3_prepare_v2(db, "DELETE FROM matches;", -1, &stmt, &z_tail) != SQLITE_OK) {
-        printf("error DELETE FROM matches\n");
-        return;
-    }
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        printf("error DELETE FROM matches\n");
-        return;
-    }
-    // 4 删除原始two_view_geometries记录
-    if (sqlite3_prepare_v2(db, "DELETE FROM two_view_geometries;", -1, &stmt, &z_tail) !=
-        SQLITE_OK) {
-        printf("error DELETE FROM two_view_geometries\n");
-        return;
+
+    writer.BeginTransaction();
+    // 2-4 删除原始 keypoints / matches / two_view_geometries 记录，追加模式下保留
+    if (!options.append) {
+        writer.ClearFeatures();
     }
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        printf("error DELETE FROM two_view_geometries\n");
-        return;
+    // 5 保存为 match.txt；直接写入 two_view_geometries 时不再需要 matches_importer 读取文本
+    bool write_geometries(options.write_geometries || options.verify);
+    std::ofstream fs;
+    if (!write_geometries) {
+        fs.open(txt_path, std::ios::out);
+        if (!fs.is_open()) {
+            printf("error open txt file\n");
+            return;
+        }
     }
-    // 5 保存为 match.txt
-    std::ofstream fs(txt_path, std::ios::out);
-    if (!fs.is_open()) {
-        printf("error open txt file\n");
-        return;
+    // 有投影矩阵真值时据此计算各视图内参，用于 E = K2^T * F * K1
+    bool has_proj(write_geometries && options.proj_matrices.size() >= num_cam);
+    std::vector<Eigen::Matrix3d, Eigen::aligned_allocator<Eigen::Matrix3d>> intrinsics;
+    if (has_proj) {
+        for (int i = 0; i < num_cam; ++i) {
+            intrinsics.push_back(IntrinsicsFromProjection(options.proj_matrices[i]));
+        }
     }
+    std::vector<uint32_t> old_matches;
+    std::vector<std::pair<int, int>> merged_matches, merged_inliers;
+    TwoViewGeometryRow old_geometry;
     for (int i = 0; i < num_cam; ++i) {
         int cam_id = cameras[i].GetId();
         int num_points = cameras[i].NumKeypoints();
-        std::pair<float, float> *points_buffer = new std::pair<float, float>[num_points];
-        // 拷贝点至blob buffer
-        for (const auto &element : cameras[i].m_keypoints) {
-            int id = element.second;
-            points_buffer[id] = element.first;
-        }
-        // 5.1 写入keypoints
-        char sql[255];
-        sprintf(sql, "insert into keypoints values('%d','%d', '%d', ?);", cam_id, num_points, 2);
-        sqlite3_prepare(db, sql, strlen(sql), &stmt, 0);
-        {
-            sqlite3_bind_blob(stmt, 1, points_buffer, num_points * sizeof(std::pair<float, float>),
-                              nullptr);
-            sqlite3_step(stmt);
-        }
-        sqlite3_finalize(stmt);
+        // 5.1 写入keypoints：m_keypoints 已按特征点 id 连续排列，即 COLMAP 的 rows x 2 float 格式，直接绑定
+        writer.WriteKeypoints(cam_id, cameras[i].m_keypoints.data(), num_points, 2);
         // 5.2 写入matches
         for (int j = i + 1; j < num_cam; ++j) {
             uint32_t id_1 = cam_id;
             uint32_t id_2 = cameras[j].GetId();
             uint64_t pair_id = ImageIdsToPairId(id_1, id_2);
-            int num_match = cameras[i].m_matches[j].size();
-            std::pair<int, int> *matches_buffer = new std::pair<int, int>[num_match];
-            memcpy(matches_buffer, &cameras[i].m_matches[j][0],
-                   num_match * sizeof(std::pair<int, int>));
-            // 写入db
-            memset(sql, 255, 0);
-            sprintf(sql, "insert into matches values('%ld','%d', '%d', ?);", pair_id, num_match, 2);
-            sqlite3_prepare(db, sql, strlen(sql), &stmt, 0);
-            {
-                sqlite3_bind_blob(stmt, 1, matches_buffer, num_match * sizeof(std::pair<int, int>),
-                                  nullptr);
-                sqlite3_step(stmt);
+            // 追加模式：已有的匹配在前，本次的新匹配接在后面
+            const std::vector<std::pair<int, int>> *matches = &cameras[i].m_matches[j];
+            if (options.append && writer.ReadMatches(pair_id, old_matches) &&
+                !old_matches.empty()) {
+                AssignPairs(old_matches, merged_matches);
+                merged_matches.insert(merged_matches.end(), matches->begin(), matches->end());
+                matches = &merged_matches;
+            }
+            int num_match = matches->size();
+            // 写入db：匹配同样连续存放，直接绑定
+            writer.WriteMatches(pair_id, matches->data(), num_match, 2);
+            if (write_geometries) {
+                // COLMAP 按行优先存储 F / E
+                typedef Eigen::Matrix<double, 3, 3, Eigen::RowMajor> RowMatrix3d;
+                RowMatrix3d F, E;
+                bool has_F(false);
+                // ChArUco 按 ID 得到的对应关系本身就是正确的，不校验时全部作为内点
+                const std::vector<std::pair<int, int>> *inliers = &cameras[i].m_matches[j];
+                if (options.verify) {
+                    const PairGeometry &geometry = geometries[i * num_cam + j];
+                    if (!geometry.valid) {
+                        continue;
+                    }
+                    inliers = &geometry.inliers;
+                    F = geometry.F;
+                    has_F = true;
+                } else if (has_proj) {
+                    F = FundamentalFromProjections(options.proj_matrices[i],
+                                                   options.proj_matrices[j]);
+                    has_F = true;
+                }
+                if (inliers->empty()) {
+                    continue;
+                }
+                // 追加模式：沿用已有的 F / E / H，只追加内点
+                if (options.append && writer.ReadTwoViewGeometry(pair_id, old_geometry)) {
+                    AssignPairs(old_geometry.data, merged_inliers);
+                    merged_inliers.insert(merged_inliers.end(), inliers->begin(), inliers->end());
+                    auto Blob = [](const std::vector<double> &m) {
+                        return m.size() == 9 ? m.data() : nullptr;
+                    };
+                    writer.WriteTwoViewGeometry(pair_id, merged_inliers.data(),
+                                                merged_inliers.size(), 2, old_geometry.config,
+                                                Blob(old_geometry.F), Blob(old_geometry.E),
+                                                Blob(old_geometry.H));
+                    continue;
+                }
+                if (has_F && has_proj) {
+                    E = EssentialFromFundamental(F, intrinsics[i], intrinsics[j]);
+                    writer.WriteTwoViewGeometry(pair_id, inliers->data(), inliers->size(), 2,
+                                                TWO_VIEW_CALIBRATED, F.data(), E.data(), nullptr);
+                } else {
+                    writer.WriteTwoViewGeometry(pair_id, inliers->data(), inliers->size(), 2,
+                                                TWO_VIEW_UNCALIBRATED, has_F ? F.data() : nullptr,
+                                                nullptr, nullptr);
+                }
+                continue;
             }
-            sqlite3_finalize(stmt);
-            delete[] matches_buffer;
-            matches_buffer = nullptr;
             // 写入txt
             if (i != 0 || j != 1) {
                 fs << std::endl;
             }
             fs << cam_name[id_1] << " " << cam_name[id_2] << std::endl;
             for (int k = 0; k < num_match; ++k) {
-                fs << cameras[i].m_matches[j][k].first << " " << cameras[i].m_matches[j][k].second
-                   << std::endl;
+                fs << (*matches)[k].first << " " << (*matches)[k].second << std::endl;
             }
         }
-        delete[] points_buffer;
-        points_buffer = nullptr;
     }
-    sqlite3_close(db);
+    writer.Commit();
+    writer.PrintStats();
+    writer.Close();
     fs.close();
 }
 
+// 读取 xmlPath（%d 为相机编号）中的投影矩阵真值，优先使用 xml 目录下的 cameras.sqcm 缓存
+void Matcher::LoadProjections(const string &xmlPath, int cameraNumber) {
+    m_proj.clear();
+    m_image_sizes.clear();
+    vector<string> xml_paths;
+    for (int camID = 0; camID < cameraNumber; ++camID) {
+        boost::format fmt(xmlPath);
+        xml_paths.push_back((fmt % camID).str());
+    }
+    auto load_start = chrono::steady_clock::now();
+    typedef Eigen::Matrix<double, 3, 4, Eigen::RowMajor> RowMatrix3x4d;
+
+    // 二进制缓存放在 xml 所在目录，xml 没有变化时直接映射，不再解析
+    string cache_path(xml_paths.empty() ? string()
+                                        : xml_paths[0].substr(0, xml_paths[0].find_last_of('/') + 1) +
+                                              "cameras.sqcm");
+    CameraCache cache;
+    if (!xml_paths.empty() && cache.Load(cache_path, xml_paths)) {
+        for (int camID = 0; camID < cameraNumber; ++camID) {
+            m_proj.push_back(Eigen::Map<const RowMatrix3x4d>(cache[camID].P));
+            m_image_sizes.push_back({cache[camID].width, cache[camID].height});
+        }
+        cout << "载入相机缓存 " << cache_path << ", 耗时 "
+             << chrono::duration<double, milli>(chrono::steady_clock::now() - load_start).count()
+             << " ms" << endl;
+        return;
+    }
+
+    vector<CameraRecord> records(cameraNumber);
+    bool all_stat(true);
+    for (int camID = 0; camID < cameraNumber; ++camID) {
+        const string &path = xml_paths[camID];
+        FileStorage xmlFile = FileStorage(path, FileStorage::READ);
+        Mat matrixP_4x4(4, 4, CV_64F);
+        Mat matrixP_3x4(3, 4, CV_64F);
+        xmlFile["P"] >> matrixP_4x4;
+
+        matrixP_3x4 = matrixP_4x4.rowRange(0, 3).clone();
+        matrixP_3x4.convertTo(matrixP_3x4, CV_64F);
+
+        Matrix3x4d P;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                P(r, c) = matrixP_3x4.at<double>(r, c);
+            }
+        }
+        m_proj.push_back(P);
+
+        // 图像尺寸决定可见范围，xml 中没有时按 1920x1080
+        CameraRecord &record = records[camID];
+        all_stat = CameraCache::StatXml(path, record) && all_stat;
+        Eigen::Map<RowMatrix3x4d>(record.P) = P;
+        record.width = 1920;
+        record.height = 1080;
+        if (!xmlFile["width"].empty() && !xmlFile["height"].empty()) {
+            xmlFile["width"] >> record.width;
+            xmlFile["height"] >> record.height;
+        }
+        m_image_sizes.push_back({record.width, record.height});
+    }
+    cout << "解析 " << cameraNumber << " 个 xml, 耗时 "
+         << chrono::duration<double, milli>(chrono::steady_clock::now() - load_start).count()
+         << " ms" << endl;
+    if (all_stat && !records.empty()) {
+        CameraCache::Save(cache_path, records);
+    }
+}
+
 /**
  * @brief 根据标定参数真值，生成符合实验要求的随机三维点
  * 
@@ -258,150 +741,143 @@ void ExtractToDatabase(int num_cam, const std::string &db_path, const std::strin
  * @param noise2D 二维检测误差
  * @param has_circle 自然特征分布：特征点在相机阵列之外的情况
  * @param is_track_exp 共视相机数量需要单独处理
+ * @param seed 随机数种子，各块候选点的随机数流由它派生，相同 seed 的结果与线程数无关
  */
 void Matcher::generateRandomPoints(const string &xmlPath, int cameraNumber, int maxPoints,
                                    vector<vector<int>> boxSize, vector<int> trackRange, int noise2D,
-                                   bool has_circle, bool is_track_exp) {
-    // 1. 读取标定参数的真值
-    vector<Mat> Mat_P;
-    for (int camID = 0; camID < cameraNumber; ++camID) {
-        boost::format fmt(xmlPath);
-        string path = (fmt % camID).str();
-        FileStorage xmlFile = FileStorage(path, FileStorage::READ);
-        Mat matrixP_4x4(4, 4, CV_64F);
-        Mat matrixP_3x4(3, 4, CV_64F);
-        xmlFile["P"] >> matrixP_4x4;
-
-        matrixP_3x4 = matrixP_4x4.rowRange(0, 3).clone();
-        matrixP_3x4.convertTo(matrixP_3x4, CV_64F);
-        Mat_P.push_back(matrixP_3x4);
+                                   bool has_circle, bool is_track_exp, uint64_t seed) {
+    // 1. 读取标定参数的真值，已经载入时直接复用
+    if (m_proj.size() != cameraNumber) {
+        LoadProjections(xmlPath, cameraNumber);
     }
 
-    // 2. 随机生成三维点
-    random_device rd;
-    mt19937 mt(rd());
-    std::default_random_engine generator(mt());
+    // 2. 随机生成三维点：候选点按块生成，第 b 块使用由 (seed, 分布, b) 决定的独立随机数流，
+    // 多个线程同时生成若干块，再按块号顺序接受，结果只取决于 seed，与线程数无关
+    const int kBlock = 256; // 每块候选点数
+    PointProjector projector(m_proj, m_image_sizes);
 
-    // 当特征点在相机阵列之外时，仍要保证阵列之内仍有少部分特征点，否则会标定失败
-    int rectanglePointsNum = has_circle ? 100 : maxPoints;
-    
-    for (int Points2DCount = 0; Points2DCount < maxPoints; ++Points2DCount) {
-        while (true) {
-            MatchData tmp_match_data(cameraNumber);  // 保存本轮三维点的结果
-            vector<double> randomXYZ1; // 齐次坐标
-
-            // 自然特征分布：
-            // 先在相机阵列内产生 rectanglePointsNum 个点，这部分和其他实验情况通用；
-            // 再把剩余点作为圆环夹层，放在相机阵列外围，进行模拟
-            if (has_circle && Points2DCount >= rectanglePointsNum) {
-                int R(40000), thickness(2000); // thickness 为圆环夹层的厚度
-                double randomX, randomY, randomZ;
-                // 随机坐标满足：R^2 <= x^2+y^2+z^2 <= (R+thickness)^2
-                do {
-                    std::uniform_real_distribution<double> dist_xy(-(R + thickness), R + thickness);
-                    randomX = dist_xy(generator);
-                    randomY = dist_xy(generator);
-                } while (pow(randomX, 2) + pow(randomY, 2) < pow(R, 2) || pow(randomX, 2) + pow(randomY, 2) > pow(R + thickness, 2));
+    const int kRadius(40000), kThickness(2000); // 圆环夹层的半径和厚度
 
-                std::uniform_real_distribution<double> dist_z(0, 2500); // 高度为 2.5m
-                randomZ = dist_z(generator);
+    // 预先统计 box 内各单元的共视数量，只在可能满足共视要求的单元中采样，
+    // 不再在整个 box 内盲目采样后丢弃大部分点
+    auto grid_start = chrono::steady_clock::now();
+    // 像素坐标加上 [noise2D - 1, noise2D] 的噪声后再判断可见，网格按噪声上界放宽图像范围
+    double max_noise = std::max(std::abs(noise2D - 1), std::abs(noise2D));
+    VisibilityGrid grid(projector, boxSize, is_track_exp ? trackRange[0] : 2, max_noise);
+    cout << "共视网格: 候选区域占 " << grid.Fraction() * 100 << "%, 耗时 "
+         << chrono::duration<double, milli>(chrono::steady_clock::now() - grid_start).count()
+         << " ms" << endl;
+
+    // 生成第 block 块候选点，把符合共视要求的轨迹写入 tracks
+    auto generate_block = [&](bool in_circle, uint64_t block, TrackStore &tracks) {
+        std::mt19937_64 generator(SplitMix64(seed ^ SplitMix64(block * 2 + in_circle)));
+        tracks.Reset(cameraNumber);
 
-                randomXYZ1.push_back(randomX);
-                randomXYZ1.push_back(randomY);
-                randomXYZ1.push_back(randomZ);
-                randomXYZ1.push_back(1.0);
+        Eigen::Matrix4Xd candidates(4, kBlock); // 齐次坐标
+        for (int n = 0; n < kBlock; ++n) {
+            if (in_circle) {
+                // 直接在圆环内均匀采样：R^2 <= x^2+y^2 <= (R+thickness)^2，半径的平方均匀分布
+                std::uniform_real_distribution<double> dist_r2(pow(kRadius, 2),
+                                                               pow(kRadius + kThickness, 2));
+                std::uniform_real_distribution<double> dist_theta(0, 2 * M_PI);
+                double radius = sqrt(dist_r2(generator));
+                double theta = dist_theta(generator);
+                std::uniform_real_distribution<double> dist_z(0, 2500); // 高度为 2.5m
+                candidates.col(n) << radius * cos(theta), radius * sin(theta),
+                    dist_z(generator), 1.0;
             } else {
-                // 生成在指定范围 box 内的三维点
-                for (int axis = 0; axis < boxSize.size(); axis++) {
-                    std::uniform_int_distribution<int> distribution(boxSize[axis][0],
-                                                                    boxSize[axis][1]);
-                    randomXYZ1.emplace_back(distribution(generator));
-                }
-                randomXYZ1.emplace_back(1.0);
+                // 只在可能满足共视要求的单元内生成 box 内的三维点
+                candidates.col(n) << grid.Sample(generator), 1.0;
             }
+        }
 
-            // 转成矩阵表达方式，为反投影计算做准备
-            Mat randomXYZ1Mat(4, 1, CV_64F);
-            for (int i = 0; i < 4; i++) {
-                randomXYZ1Mat.at<double>(i, 0) = randomXYZ1[i];
-            }
+        // 一次投影整块候选点，加入 2D 检测噪声，
+        // 合法性校验：反投影得到的像素坐标点要在该相机的图像范围内
+        Eigen::MatrixXd pixel_u, pixel_v; // cameraNumber x kBlock
+        Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> visible;
+        uniform_real_distribution<> noise(noise2D - 1, noise2D);
+        auto draw_noise = [&]() { return noise(generator); };
+        projector.Project(candidates, pixel_u, pixel_v);
+        pixel_u += Eigen::MatrixXd::NullaryExpr(cameraNumber, kBlock, draw_noise);
+        pixel_v += Eigen::MatrixXd::NullaryExpr(cameraNumber, kBlock, draw_noise);
+        projector.Visible(pixel_u, pixel_v, visible);
 
-            int valid_num = 0;
+        vector<int> visible_cams;
+        for (int n = 0; n < kBlock; ++n) {
+            visible_cams.clear();
             for (int cam_id = 0; cam_id < cameraNumber; ++cam_id) {
-                Mat random2DPointMat(3, 1, CV_64F);
-                random2DPointMat = Mat_P[cam_id] * randomXYZ1Mat;
-
-                // 需要除以最后一个元素，得到正确的 (u,v,1)
-                random2DPointMat.at<double>(0, 0) /= random2DPointMat.at<double>(2, 0);
-                random2DPointMat.at<double>(1, 0) /= random2DPointMat.at<double>(2, 0);
-                random2DPointMat.at<double>(2, 0) = 1;
-
-                // 加入 2D 检测噪声
-                uniform_real_distribution<> distribution(noise2D - 1, noise2D);
-                random2DPointMat.at<double>(0, 0) += distribution(generator);
-                random2DPointMat.at<double>(1, 0) += distribution(generator);
-
-                // 合法性校验：反投影得到的像素坐标点要在图像分辨率(1920x1080)范围内
-                if (random2DPointMat.at<double>(0, 0) < 1920 &&
-                    random2DPointMat.at<double>(1, 0) < 1080 &&
-                    random2DPointMat.at<double>(0, 0) >= 0 &&
-                    random2DPointMat.at<double>(1, 0) >= 0) {
-                    // 临时保存结果
-                    tmp_match_data.FillData(cam_id, random2DPointMat.at<double>(0, 0),
-                                            random2DPointMat.at<double>(1, 0));
-                    ++valid_num; // 反投影成功的相机数量，即共视数量
-                } else {
-                    tmp_match_data.FillData(cam_id, -1, -1);
+                if (visible(cam_id, n)) {
+                    visible_cams.push_back(cam_id);
                 }
             }
-
-            if (!is_track_exp && valid_num >= 2) { // 未进行共视关系实验：只要共视大于 2 即认为符合要求，要求太高的话很难满足
-                m_match_data.emplace_back(tmp_match_data);
-                break;
+            int valid_num = visible_cams.size(); // 反投影成功的相机数量，即共视数量
+            // 未进行共视关系实验：只要共视大于 2 即认为符合要求，要求太高的话很难满足
+            if (valid_num < (is_track_exp ? trackRange[0] : 2)) {
+                continue;
+            }
+            if (is_track_exp && valid_num > trackRange[1]) {
+                // 共视数量大于指定数，则在可见的相机中随机保留 trackNumber 个（部分洗牌），其余取消共视关系
+                uniform_int_distribution<int> distribution(trackRange[0], trackRange[1]);
+                int trackNumber = distribution(generator); // 指定共视关系数目
+                for (int i = 0; i < trackNumber; ++i) {
+                    uniform_int_distribution<int> pick(i, valid_num - 1);
+                    std::swap(visible_cams[i], visible_cams[pick(generator)]);
+                }
+                visible_cams.resize(trackNumber);
+                std::sort(visible_cams.begin(), visible_cams.end());
+            }
+            for (int cam_id : visible_cams) { // 只把可见的视图写入轨迹
+                tracks.AddObservation(cam_id, pixel_u(cam_id, n), pixel_v(cam_id, n));
             }
+            tracks.FinishTrack();
+        }
+    };
 
-            if (is_track_exp) {
-                if (valid_num < trackRange[0]) {
-                    continue;
-                } else if (valid_num <= trackRange[1]) {
-                    m_match_data.emplace_back(tmp_match_data);
-                    break;
-                } else { // 共视数量大于指定数，则随机选择视点改为(-1,-1)，取消在该视点的共视关系
-                    vector<int> randomCamera; // 
-                    uniform_int_distribution<int> distribution(trackRange[0], trackRange[1]);
-                    int trackNumber = distribution(generator); // 指定共视关系数目
-
-                    int randomCount = 0;
-                    while (randomCount < cameraNumber - trackNumber) {
-                        default_random_engine generator(mt()); // 为了防止随机数重复，重新指定因子
-                        uniform_int_distribution<int> distribution(0, cameraNumber);
-                        int randomCameraID = distribution(generator); 
-                        
-                        // 验证：是否能把 randomCameraID 相机置为 (-1,-1)
-                        if (randomCamera.size() == 0) {
-                            randomCamera.emplace_back(randomCameraID);
-                            randomCount++;
-                            continue;
-                        } else {
-                            auto result = find(randomCamera.begin(), randomCamera.end(), randomCameraID);
-                            if (result == randomCamera.end()) { // 所选的 ID 未重复，可以放心加入
-                                randomCamera.emplace_back(randomCameraID);
-                                randomCount++;
-                            } else { // 生成的 ID 重复！需要重新生成
-                                continue;
-                            }
-                        }
-                    }
-                    for (auto id : randomCamera) {
-                        tmp_match_data.FillData(id, -1, -1);
+    // 从第 0 块开始按块号顺序接受 num_points 条轨迹
+    size_t num_candidates(0);
+    auto generate = [&](bool in_circle, int num_points) {
+        int round_blocks = 2 * omp_get_max_threads(); // 每轮并行生成的块数，不影响结果
+        vector<TrackStore> blocks(round_blocks);
+        uint64_t next_block(0);
+        int accepted(0);
+        while (accepted < num_points) {
+#pragma omp parallel for schedule(dynamic, 1)
+            for (int k = 0; k < round_blocks; ++k) {
+                generate_block(in_circle, next_block + k, blocks[k]);
+            }
+            next_block += round_blocks;
+            num_candidates += (size_t)round_blocks * kBlock;
+            for (int k = 0; k < round_blocks && accepted < num_points; ++k) {
+                for (uint32_t t = 0; t < blocks[k].NumTracks() && accepted < num_points; ++t) {
+                    for (uint32_t i = blocks[k].Begin(t); i < blocks[k].End(t); ++i) {
+                        m_match_data.AddObservation(blocks[k].m_cam_ids[i], blocks[k].m_u[i],
+                                                    blocks[k].m_v[i]);
                     }
-                    m_match_data.emplace_back(tmp_match_data);
-                    break;
+                    m_match_data.FinishTrack();
+                    ++accepted;
                 }
             }
         }
+    };
+
+    auto generate_start = chrono::steady_clock::now();
+    m_match_data.Reset(cameraNumber);
+    m_match_data.Reserve(maxPoints, 0);
+    // 自然特征分布：
+    // 先在相机阵列内产生 rectanglePointsNum 个点，这部分和其他实验情况通用；
+    // 再把剩余点作为圆环夹层，放在相机阵列外围，进行模拟。
+    // 当特征点在相机阵列之外时，仍要保证阵列之内仍有少部分特征点，否则会标定失败
+    int rectanglePointsNum = has_circle ? std::min(100, maxPoints) : maxPoints;
+    generate(false, rectanglePointsNum);
+    if (has_circle) {
+        generate(true, maxPoints - rectanglePointsNum);
     }
 
+    cout << "候选点 " << num_candidates << " 个, 接受率 "
+         << (num_candidates > 0 ? 100.0 * maxPoints / num_candidates : 0.0) << "%" << endl;
+    m_match_data.PrintStats("随机点轨迹",
+        chrono::duration<double, milli>(chrono::steady_clock::now() - generate_start).count());
+
     // ! Log File
     // ofstream fs("./log.txt");
     // for (auto i : m_match_data) {
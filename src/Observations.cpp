@@ -0,0 +1,148 @@
+#include "Observations.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+const char kObservationMagic[4] = {'S', 'Q', 'O', 'B'};
+const uint32_t kObservationVersion = 1;
+
+#pragma pack(push, 1)
+struct ObservationHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t cam_num;
+    uint32_t reserved;
+    uint64_t track_offset;
+    uint64_t num_tracks;
+    uint64_t num_observations;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(Observation) == 16, "Observation must be tightly packed");
+
+// 打开文件并读取、校验文件头和观测数，成功时 fp 停在第一条观测处
+FILE *OpenObservations(const std::string &path, ObservationHeader &header) {
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr) {
+        printf("error open observation file %s\n", path.c_str());
+        return nullptr;
+    }
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, kObservationMagic, 4) != 0 ||
+        header.version != kObservationVersion) {
+        printf("error observation file %s format\n", path.c_str());
+        fclose(fp);
+        return nullptr;
+    }
+    // 观测数先与文件大小核对，损坏的文件头不会导致按错误的数量分配内存
+    long file_size(-1);
+    if (fseek(fp, 0, SEEK_END) == 0) {
+        file_size = ftell(fp);
+    }
+    if (file_size < (long)sizeof(header) ||
+        header.num_observations > (file_size - sizeof(header)) / sizeof(Observation) ||
+        fseek(fp, sizeof(header), SEEK_SET) != 0) {
+        printf("error observation file %s truncated\n", path.c_str());
+        fclose(fp);
+        return nullptr;
+    }
+    return fp;
+}
+
+}  // namespace
+
+bool WriteObservations(const std::string &path, const ObservationFile &file) {
+    // 头部和观测拼成一块连续内存，一次 fwrite 写出
+    ObservationHeader header;
+    memcpy(header.magic, kObservationMagic, 4);
+    header.version = kObservationVersion;
+    header.cam_num = file.cam_num;
+    header.reserved = 0;
+    header.track_offset = file.track_offset;
+    header.num_tracks = file.num_tracks;
+    header.num_observations = file.observations.size();
+
+    size_t obs_bytes = file.observations.size() * sizeof(Observation);
+    std::vector<char> buffer(sizeof(header) + obs_bytes);
+    memcpy(buffer.data(), &header, sizeof(header));
+    if (obs_bytes > 0) {
+        memcpy(buffer.data() + sizeof(header), file.observations.data(), obs_bytes);
+    }
+
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        printf("error open observation file %s\n", path.c_str());
+        return false;
+    }
+    bool ok = fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size();
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok) {
+        printf("error write observation file %s\n", path.c_str());
+    }
+    return ok;
+}
+
+bool ReadObservationHeader(const std::string &path, ObservationFile &file,
+                           uint64_t &num_observations) {
+    ObservationHeader header;
+    FILE *fp = OpenObservations(path, header);
+    if (fp == nullptr) {
+        return false;
+    }
+    fclose(fp);
+    file.cam_num = header.cam_num;
+    file.track_offset = header.track_offset;
+    file.num_tracks = header.num_tracks;
+    file.observations.clear();
+    num_observations = header.num_observations;
+    return true;
+}
+
+bool ReadObservations(const std::string &path, ObservationFile &file) {
+    ObservationHeader header;
+    FILE *fp = OpenObservations(path, header);
+    if (fp == nullptr) {
+        return false;
+    }
+    file.cam_num = header.cam_num;
+    file.track_offset = header.track_offset;
+    file.num_tracks = header.num_tracks;
+    file.observations.resize(header.num_observations);
+    size_t n = file.observations.empty()
+                   ? 0
+                   : fread(file.observations.data(), sizeof(Observation),
+                           file.observations.size(), fp);
+    fclose(fp);
+    if (n != file.observations.size()) {
+        printf("error observation file %s truncated\n", path.c_str());
+        return false;
+    }
+    // 相机编号越界或 track_id 乱序的记录会在导出时越界写或被丢弃，整个文件视为损坏
+    for (size_t k = 0; k < file.observations.size(); ++k) {
+        const Observation &obs = file.observations[k];
+        if (obs.cam_id >= file.cam_num || obs.track_id >= file.num_tracks ||
+            (k > 0 && obs.track_id < file.observations[k - 1].track_id)) {
+            printf("error observation file %s record %zu (track %u, camera %u) invalid\n",
+                   path.c_str(), k, obs.track_id, obs.cam_id);
+            file.observations.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+void AppendTracks(const ObservationFile &file, TrackStore &tracks) {
+    tracks.Reserve(tracks.NumTracks() + file.num_tracks,
+                   tracks.NumObservations() + file.observations.size());
+    size_t k(0);
+    for (uint64_t track_id = 0; track_id < file.num_tracks; ++track_id) {
+        for (; k < file.observations.size() && file.observations[k].track_id == track_id; ++k) {
+            const Observation &obs = file.observations[k];
+            tracks.AddObservation(obs.cam_id, obs.u, obs.v);
+        }
+        tracks.FinishTrack();
+    }
+}
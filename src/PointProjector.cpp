@@ -0,0 +1,225 @@
+#include "PointProjector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <opencv2/core.hpp>
+
+PointProjector::PointProjector(const ProjectionList &proj, const ImageSizeList &image_sizes)
+    : m_rows_u(proj.size(), 4),
+      m_rows_v(proj.size(), 4),
+      m_rows_w(proj.size(), 4),
+      m_width(Eigen::ArrayXd::Constant(proj.size(), 1920)),
+      m_height(Eigen::ArrayXd::Constant(proj.size(), 1080)) {
+    for (int cam_id = 0; cam_id < proj.size(); ++cam_id) {
+        m_rows_u.row(cam_id) = proj[cam_id].row(0);
+        m_rows_v.row(cam_id) = proj[cam_id].row(1);
+        m_rows_w.row(cam_id) = proj[cam_id].row(2);
+        if (cam_id < image_sizes.size()) {
+            m_width(cam_id) = image_sizes[cam_id].x();
+            m_height(cam_id) = image_sizes[cam_id].y();
+        }
+    }
+}
+
+void PointProjector::Project(const Eigen::Ref<const Eigen::Matrix4Xd> &points,
+                             Eigen::MatrixXd &u, Eigen::MatrixXd &v) const {
+    Eigen::ArrayXXd w = (m_rows_w * points).array();
+    u.noalias() = m_rows_u * points;
+    v.noalias() = m_rows_v * points;
+    u.array() /= w;
+    v.array() /= w;
+}
+
+void PointProjector::Depth(const Eigen::Ref<const Eigen::Matrix4Xd> &points,
+                           Eigen::MatrixXd &w) const {
+    w.noalias() = m_rows_w * points;
+}
+
+bool PointProjector::Overlaps(int cam_id, double u_min, double u_max, double v_min,
+                              double v_max) const {
+    return u_max >= 0 && u_min < m_width(cam_id) && v_max >= 0 && v_min < m_height(cam_id);
+}
+
+void PointProjector::Visible(const Eigen::MatrixXd &u, const Eigen::MatrixXd &v,
+                             Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> &visible) const {
+    visible = u.array() >= 0 && u.array() < m_width.replicate(1, u.cols()) && v.array() >= 0 &&
+              v.array() < m_height.replicate(1, v.cols());
+}
+
+VisibilityGrid::VisibilityGrid(const PointProjector &projector,
+                               const std::vector<std::vector<int>> &box, int min_views,
+                               double margin, int cells_per_axis) {
+    int n[3];
+    m_box_points = 1;
+    for (int axis = 0; axis < 3; ++axis) {
+        int count = box[axis][1] - box[axis][0] + 1;
+        n[axis] = std::max(1, std::min(cells_per_axis, count));
+        for (int i = 0; i <= n[axis]; ++i) {
+            m_edges[axis].push_back(box[axis][0] + (int64_t)i * count / n[axis]);
+        }
+        m_box_points *= count;
+    }
+    int num_cells = n[0] * n[1] * n[2];
+    auto CornerIndex = [&](int x, int y) { return y * (n[0] + 1) + x; };
+    auto CellIndex = [&](int x, int y, int z) { return (z * n[1] + y) * n[0] + x; };
+
+    // 1. 按 z 方向逐层投影角点，只保留相邻两层；第 z - 1 层和第 z 层之间为第 z - 1 层单元
+    int cam_num(projector.NumCameras());
+    int layer_size = (n[0] + 1) * (n[1] + 1);
+    Eigen::Matrix4Xd layer(4, layer_size);
+    Eigen::MatrixXd u[2], v[2], w[2]; // cam_num x layer_size
+    std::vector<char> qualified(num_cells, 0);
+    for (int z = 0; z <= n[2]; ++z) {
+        for (int y = 0; y <= n[1]; ++y) {
+            for (int x = 0; x <= n[0]; ++x) {
+                layer.col(CornerIndex(x, y)) << m_edges[0][x], m_edges[1][y], m_edges[2][z], 1.0;
+            }
+        }
+        projector.Project(layer, u[z % 2], v[z % 2]);
+        projector.Depth(layer, w[z % 2]);
+        if (z == 0) {
+            continue;
+        }
+
+        // 2. 统计每个单元的可见相机数。8 个角点都在相机同一侧时，单元的投影就是角点投影的凸包，
+        // 用包围盒（向外扩展 margin）与图像求交；角点跨过相机平面时按可见处理。
+        // 判断只会多算不会漏算，候选区域包含所有满足共视要求的点
+        for (int y = 0; y < n[1]; ++y) {
+            for (int x = 0; x < n[0]; ++x) {
+                int views(0);
+                for (int cam_id = 0; cam_id < cam_num && views < min_views; ++cam_id) {
+                    double u_min(INFINITY), u_max(-INFINITY), v_min(INFINITY), v_max(-INFINITY);
+                    int front(0), back(0);
+                    for (int k = 0; k < 8; ++k) {
+                        int l = (z - 1 + (k >> 2)) % 2;
+                        int corner = CornerIndex(x + (k & 1), y + (k >> 1 & 1));
+                        double depth = w[l](cam_id, corner);
+                        front += depth > 0;
+                        back += depth < 0;
+                        u_min = std::min(u_min, u[l](cam_id, corner));
+                        u_max = std::max(u_max, u[l](cam_id, corner));
+                        v_min = std::min(v_min, v[l](cam_id, corner));
+                        v_max = std::max(v_max, v[l](cam_id, corner));
+                    }
+                    views += (front < 8 && back < 8) ||
+                             projector.Overlaps(cam_id, u_min - margin, u_max + margin,
+                                                v_min - margin, v_max + margin);
+                }
+                qualified[CellIndex(x, y, z - 1)] = views >= min_views;
+            }
+        }
+    }
+
+    // 3. 候选单元和各自的整数点数
+    uint64_t total(0);
+    m_prefix.push_back(0);
+    for (int cell = 0; cell < num_cells; ++cell) {
+        int x = cell % n[0], y = cell / n[0] % n[1], z = cell / (n[0] * n[1]);
+        uint64_t size = (uint64_t)(m_edges[0][x + 1] - m_edges[0][x]) *
+                        (m_edges[1][y + 1] - m_edges[1][y]) * (m_edges[2][z + 1] - m_edges[2][z]);
+        if (qualified[cell] && size > 0) {
+            m_cells.push_back(cell);
+            total += size;
+            m_prefix.push_back(total);
+        }
+    }
+    // 没有满足要求的单元时退化为在整个 box 内采样
+    if (m_cells.empty()) {
+        std::cout << "warning: 没有单元能被 " << min_views << " 个相机看到，在整个范围内采样"
+                  << std::endl;
+        for (int cell = 0; cell < num_cells; ++cell) {
+            int x = cell % n[0], y = cell / n[0] % n[1], z = cell / (n[0] * n[1]);
+            total += (uint64_t)(m_edges[0][x + 1] - m_edges[0][x]) *
+                     (m_edges[1][y + 1] - m_edges[1][y]) * (m_edges[2][z + 1] - m_edges[2][z]);
+            m_cells.push_back(cell);
+            m_prefix.push_back(total);
+        }
+    }
+}
+
+Eigen::Vector3d VisibilityGrid::Sample(std::mt19937_64 &generator) const {
+    // 先按整数点数选单元，再把余数分解成单元内的 (x, y, z)，整体对候选区域内的整数点均匀
+    std::uniform_int_distribution<uint64_t> distribution(0, m_prefix.back() - 1);
+    uint64_t r = distribution(generator);
+    int k = std::upper_bound(m_prefix.begin(), m_prefix.end(), r) - m_prefix.begin() - 1;
+    uint64_t offset = r - m_prefix[k];
+    int n_x = m_edges[0].size() - 1, n_y = m_edges[1].size() - 1;
+    int cell = m_cells[k];
+    int x = cell % n_x, y = cell / n_x % n_y, z = cell / (n_x * n_y);
+    int size_x = m_edges[0][x + 1] - m_edges[0][x];
+    int size_y = m_edges[1][y + 1] - m_edges[1][y];
+    // 边界可能为负数，余数先转回有符号数再相加
+    return Eigen::Vector3d(m_edges[0][x] + (int64_t)(offset % size_x),
+                           m_edges[1][y] + (int64_t)(offset / size_x % size_y),
+                           m_edges[2][z] + (int64_t)(offset / ((uint64_t)size_x * size_y)));
+}
+
+double VisibilityGrid::Fraction() const {
+    return double(m_prefix.back()) / m_box_points;
+}
+
+void BenchmarkProjection(const ProjectionList &proj, int num_points) {
+    int cam_num(proj.size());
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<double> dist(-500, 500);
+    Eigen::Matrix4Xd points(4, num_points);
+    for (int i = 0; i < num_points; ++i) {
+        points.col(i) << dist(generator), dist(generator), dist(generator) + 500, 1.0;
+    }
+
+    // 原来的做法：每个点、每个相机构造一次 cv::Mat
+    std::vector<cv::Mat> mat_p;
+    for (const auto &P : proj) {
+        cv::Mat m(3, 4, CV_64F);
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                m.at<double>(r, c) = P(r, c);
+            }
+        }
+        mat_p.push_back(m);
+    }
+    size_t mat_visible(0);
+    auto mat_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_points; ++i) {
+        cv::Mat point(4, 1, CV_64F);
+        for (int k = 0; k < 4; ++k) {
+            point.at<double>(k, 0) = points(k, i);
+        }
+        for (int cam_id = 0; cam_id < cam_num; ++cam_id) {
+            cv::Mat pixel = mat_p[cam_id] * point;
+            double u = pixel.at<double>(0, 0) / pixel.at<double>(2, 0);
+            double v = pixel.at<double>(1, 0) / pixel.at<double>(2, 0);
+            mat_visible += (u >= 0 && u < 1920 && v >= 0 && v < 1080);
+        }
+    }
+    double mat_s =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - mat_start).count();
+
+    // 批量投影，每块 kBlock 个点
+    const int kBlock = 256;
+    PointProjector projector(proj);
+    Eigen::MatrixXd u, v;
+    Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> visible;
+    size_t batch_visible(0);
+    auto batch_start = std::chrono::steady_clock::now();
+    for (int begin = 0; begin < num_points; begin += kBlock) {
+        int n = std::min(kBlock, num_points - begin);
+        projector.Project(points.middleCols(begin, n), u, v);
+        projector.Visible(u, v, visible);
+        batch_visible += visible.count();
+    }
+    double batch_s =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+
+    std::cout << "投影基准 (" << num_points << " 点 x " << cam_num << " 相机):" << std::endl;
+    std::cout << "  cv::Mat 逐点: " << num_points / mat_s << " 点/秒" << std::endl;
+    std::cout << "  Eigen 批量:   " << num_points / batch_s << " 点/秒, 加速 " << mat_s / batch_s
+              << " 倍" << std::endl;
+    if (mat_visible != batch_visible) {
+        std::cout << "  warning: 可见观测数不一致 " << mat_visible << " vs " << batch_visible
+                  << std::endl;
+    }
+}
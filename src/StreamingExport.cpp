@@ -0,0 +1,236 @@
+#include "StreamingExport.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "DatabaseWriter.h"
+#include "Utilities.h"
+
+namespace {
+
+// 特征点为 2 个 float，匹配为 2 个 uint32
+const size_t kRowBytes = 2 * sizeof(uint32_t);
+
+}  // namespace
+
+StreamingExporter::StreamingExporter(int num_cam, const std::string &spill_dir)
+    : m_num_cam(num_cam),
+      m_keypoints_path(spill_dir + "/keypoints.spill"),
+      m_matches_path(spill_dir + "/matches.spill"),
+      m_keypoints_file(nullptr),
+      m_matches_file(nullptr),
+      m_num_keypoints(num_cam, 0),
+      m_num_matches(num_cam * num_cam, 0),
+      m_keypoint_segments(num_cam),
+      m_match_segments(num_cam * num_cam),
+      m_num_chunks(0) {}
+
+StreamingExporter::~StreamingExporter() {
+    if (m_keypoints_file != nullptr) {
+        fclose(m_keypoints_file);
+        std::remove(m_keypoints_path.c_str());
+    }
+    if (m_matches_file != nullptr) {
+        fclose(m_matches_file);
+        std::remove(m_matches_path.c_str());
+    }
+}
+
+bool StreamingExporter::Open() {
+    m_keypoints_file = fopen(m_keypoints_path.c_str(), "w+b");
+    m_matches_file = fopen(m_matches_path.c_str(), "w+b");
+    if (m_keypoints_file == nullptr || m_matches_file == nullptr) {
+        printf("error open spill files in %s\n", m_keypoints_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void StreamingExporter::AddChunk(const TrackStore &data) {
+    // 本块内的特征点和匹配先放在内存中，大小只与块内的组数有关
+    std::vector<std::vector<float>> keypoints(m_num_cam);
+    std::vector<std::vector<uint32_t>> matches(m_num_cam * m_num_cam);
+    std::vector<uint32_t> obs_kp(data.NumObservations());
+    for (uint32_t k = 0; k < obs_kp.size(); ++k) {
+        int cam_id = data.m_cam_ids[k];
+        obs_kp[k] = m_num_keypoints[cam_id] + keypoints[cam_id].size() / 2;
+        keypoints[cam_id].push_back(data.m_u[k]);
+        keypoints[cam_id].push_back(data.m_v[k]);
+    }
+    for (uint32_t t = 0; t < data.NumTracks(); ++t) {
+        for (uint32_t a = data.Begin(t); a < data.End(t); ++a) {
+            for (uint32_t b = a + 1; b < data.End(t); ++b) {  // 轨迹内相机 id 升序
+                auto &pair = matches[data.m_cam_ids[a] * m_num_cam + data.m_cam_ids[b]];
+                pair.push_back(obs_kp[a]);
+                pair.push_back(obs_kp[b]);
+            }
+        }
+    }
+
+    // 追加到溢出文件末尾，记录分段
+    for (int i = 0; i < m_num_cam; ++i) {
+        uint32_t count = keypoints[i].size() / 2;
+        if (count == 0) {
+            continue;
+        }
+        m_keypoint_segments[i].push_back({(uint64_t)ftello(m_keypoints_file), count});
+        if (fwrite(keypoints[i].data(), kRowBytes, count, m_keypoints_file) != count) {
+            printf("error write %s\n", m_keypoints_path.c_str());
+        }
+        m_num_keypoints[i] += count;
+    }
+    for (int pair = 0; pair < m_num_cam * m_num_cam; ++pair) {
+        uint32_t count = matches[pair].size() / 2;
+        if (count == 0) {
+            continue;
+        }
+        m_match_segments[pair].push_back({(uint64_t)ftello(m_matches_file), count});
+        if (fwrite(matches[pair].data(), kRowBytes, count, m_matches_file) != count) {
+            printf("error write %s\n", m_matches_path.c_str());
+        }
+        m_num_matches[pair] += count;
+    }
+    ++m_num_chunks;
+}
+
+bool StreamingExporter::ReadSegments(FILE *file, const std::vector<Segment> &segments,
+                                     size_t row_bytes,
+                                     const std::function<bool(const char *, size_t)> &sink) {
+    size_t rows_per_read = std::max<size_t>(1, m_buffer.size() / row_bytes);
+    for (const Segment &segment : segments) {
+        if (fseeko(file, segment.offset, SEEK_SET) != 0) {
+            return false;
+        }
+        for (uint32_t done = 0; done < segment.count;) {
+            size_t rows = std::min<size_t>(rows_per_read, segment.count - done);
+            if (fread(m_buffer.data(), row_bytes, rows, file) != rows) {
+                return false;
+            }
+            if (!sink(m_buffer.data(), rows * row_bytes)) {
+                return false;
+            }
+            done += rows;
+        }
+    }
+    return true;
+}
+
+bool StreamingExporter::CopyToBlob(sqlite3 *db, const char *table, int64_t rowid, FILE *file,
+                                   const std::vector<Segment> &segments, size_t row_bytes) {
+    if (segments.empty()) {
+        return true;
+    }
+    sqlite3_blob *blob;
+    if (sqlite3_blob_open(db, "main", table, "data", rowid, 1, &blob) != SQLITE_OK) {
+        printf("error sqlite3_blob_open %s %lld: %s\n", table, (long long)rowid,
+               sqlite3_errmsg(db));
+        return false;
+    }
+    int blob_offset(0);
+    bool ok = ReadSegments(file, segments, row_bytes, [&](const char *data, size_t bytes) {
+        if (sqlite3_blob_write(blob, data, bytes, blob_offset) != SQLITE_OK) {
+            return false;
+        }
+        blob_offset += bytes;
+        return true;
+    });
+    sqlite3_blob_close(blob);
+    if (!ok) {
+        printf("error copy spill data to %s %lld\n", table, (long long)rowid);
+    }
+    return ok;
+}
+
+bool StreamingExporter::WriteDatabase(const std::string &db_path, const std::string &txt_path,
+                                      std::unordered_map<int, std::string> &cam_name,
+                                      bool write_geometries, const ProjectionList &proj_matrices,
+                                      size_t buffer_bytes) {
+    fflush(m_keypoints_file);
+    fflush(m_matches_file);
+    m_buffer.resize(std::max(buffer_bytes, kRowBytes));
+    uint64_t total_matches(0);
+    for (uint64_t n : m_num_matches) {
+        total_matches += n;
+    }
+    std::cout << "流式导出: " << m_num_chunks << " 块, 溢出文件 "
+              << (ftello(m_keypoints_file) + ftello(m_matches_file)) / (1024.0 * 1024.0)
+              << " MB, 匹配 " << total_matches << " 对, 缓冲区 " << m_buffer.size() / 1024
+              << " KB" << std::endl;
+
+    DatabaseWriter writer;
+    if (!writer.Open(db_path)) {
+        return false;
+    }
+    writer.BeginTransaction();
+    writer.ClearFeatures();
+    std::ofstream fs;
+    if (!write_geometries) {
+        fs.open(txt_path, std::ios::out);
+        if (!fs.is_open()) {
+            printf("error open txt file\n");
+            return false;
+        }
+    }
+    bool has_proj(write_geometries && proj_matrices.size() >= m_num_cam);
+    std::vector<Eigen::Matrix3d, Eigen::aligned_allocator<Eigen::Matrix3d>> intrinsics;
+    if (has_proj) {
+        for (int i = 0; i < m_num_cam; ++i) {
+            intrinsics.push_back(IntrinsicsFromProjection(proj_matrices[i]));
+        }
+    }
+
+    bool ok(true);
+    for (int i = 0; i < m_num_cam && ok; ++i) {
+        // 先插入长度确定的零 blob，再分段填充
+        writer.WriteKeypoints(i + 1, nullptr, m_num_keypoints[i], 2);
+        ok = CopyToBlob(writer.Handle(), "keypoints", i + 1, m_keypoints_file,
+                        m_keypoint_segments[i], kRowBytes);
+        for (int j = i + 1; j < m_num_cam && ok; ++j) {
+            int pair = i * m_num_cam + j;
+            int num_match = m_num_matches[pair];
+            uint64_t pair_id = ImageIdsToPairId(i + 1, j + 1);
+            writer.WriteMatches(pair_id, nullptr, num_match, 2);
+            ok = CopyToBlob(writer.Handle(), "matches", pair_id, m_matches_file,
+                            m_match_segments[pair], kRowBytes);
+            if (write_geometries) {
+                if (num_match == 0) {
+                    continue;
+                }
+                if (has_proj) {
+                    typedef Eigen::Matrix<double, 3, 3, Eigen::RowMajor> RowMatrix3d;
+                    RowMatrix3d F = FundamentalFromProjections(proj_matrices[i], proj_matrices[j]);
+                    RowMatrix3d E = EssentialFromFundamental(F, intrinsics[i], intrinsics[j]);
+                    writer.WriteTwoViewGeometry(pair_id, nullptr, num_match, 2,
+                                                TWO_VIEW_CALIBRATED, F.data(), E.data(), nullptr);
+                } else {
+                    writer.WriteTwoViewGeometry(pair_id, nullptr, num_match, 2,
+                                                TWO_VIEW_UNCALIBRATED, nullptr, nullptr, nullptr);
+                }
+                ok = ok && CopyToBlob(writer.Handle(), "two_view_geometries", pair_id,
+                                      m_matches_file, m_match_segments[pair], kRowBytes);
+                continue;
+            }
+            // 写入txt，格式与 ExtractToDatabase() 相同
+            if (i != 0 || j != 1) {
+                fs << std::endl;
+            }
+            fs << cam_name[i + 1] << " " << cam_name[j + 1] << std::endl;
+            ok = ok && ReadSegments(m_matches_file, m_match_segments[pair], kRowBytes,
+                                    [&](const char *data, size_t bytes) {
+                                        const uint32_t *ids = (const uint32_t *)data;
+                                        for (size_t k = 0; k < bytes / sizeof(uint32_t); k += 2) {
+                                            fs << ids[k] << " " << ids[k + 1] << std::endl;
+                                        }
+                                        return true;
+                                    });
+        }
+    }
+    if (!ok) {
+        sqlite3_exec(writer.Handle(), "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    writer.Commit();
+    writer.PrintStats();
+    return true;
+}
@@ -0,0 +1,106 @@
+#include "Sweep.h"
+
+#include <omp.h>
+#include <sys/stat.h>
+
+std::vector<SweepConfig> ExpandSweepGrid(const SweepOptions &options,
+                                         const SweepConfig &defaults) {
+    std::vector<int> pixel_errors(options.pixel_errors), max_points(options.max_points);
+    std::vector<std::vector<int>> track_lengths;
+    if (pixel_errors.empty()) {
+        pixel_errors.push_back(defaults.pixel_error);
+    }
+    if (max_points.empty()) {
+        max_points.push_back(defaults.max_points);
+    }
+    if (options.track_lengths.size() % 2 != 0) {
+        printf("error: --sweep_track_length 需要成对给出 (最小值, 最大值)\n");
+        return {};
+    }
+    if (!defaults.track_length.empty() && defaults.track_length.size() != 2) {
+        printf("error: --track_length 需要两个值 (最小值, 最大值)\n");
+        return {};
+    }
+    for (size_t k = 0; k + 1 < options.track_lengths.size(); k += 2) {
+        track_lengths.push_back({options.track_lengths[k], options.track_lengths[k + 1]});
+    }
+    if (track_lengths.empty()) {
+        track_lengths.push_back(defaults.track_length); // 可能为空，此时名字中不带 tl
+    }
+
+    std::vector<SweepConfig> configs;
+    for (int pixel_error : pixel_errors) {
+        for (const auto &track_length : track_lengths) {
+            for (int points : max_points) {
+                SweepConfig config;
+                config.pixel_error = pixel_error;
+                config.track_length = track_length;
+                config.max_points = points;
+                if (track_length.empty()) {
+                    config.name = (boost::format("pe%d_mp%d") % pixel_error % points).str();
+                } else {
+                    config.name = (boost::format("pe%d_tl%d-%d_mp%d") % pixel_error %
+                                   track_length[0] % track_length[1] % points).str();
+                }
+                configs.push_back(config);
+            }
+        }
+    }
+    return configs;
+}
+
+void RunSweep(const std::vector<SweepConfig> &configs, const SweepOptions &options,
+              const Matcher &base, const std::string &project_path, int cam_num,
+              const std::vector<std::vector<int>> &box_size, bool has_circle, bool is_track_exp,
+              uint64_t seed, const std::unordered_map<int, std::string> &cam_name,
+              const ExportOptions &export_options) {
+    sqlite3 *template_db = DatabaseWriter::LoadTemplate(project_path + "/database.db");
+    if (template_db == nullptr) {
+        return;
+    }
+    string sweep_dir(project_path + "/sweep");
+    mkdir(sweep_dir.c_str(), 0755);
+
+    int jobs = options.jobs > 0 ? options.jobs : omp_get_max_threads();
+    cout << "参数扫描: " << configs.size() << " 组参数, 同时运行 " << jobs << " 组" << endl;
+    // 各组参数之间并行，内部生成和导出的并行区不再嵌套开线程，扫描结束后恢复
+    int max_active_levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(1);
+    auto sweep_start = chrono::steady_clock::now();
+    vector<double> seconds(configs.size(), 0.0);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(jobs)
+    for (int k = 0; k < configs.size(); ++k) {
+        const SweepConfig &config = configs[k];
+        auto config_start = chrono::steady_clock::now();
+        string output_dir(sweep_dir + "/" + config.name);
+        mkdir(output_dir.c_str(), 0755);
+        string database_path(output_dir + "/database.db");
+        if (!DatabaseWriter::CopyTemplate(template_db, database_path)) {
+            printf("error copy database template to %s\n", database_path.c_str());
+            continue;
+        }
+
+        // 每组参数使用自己的 Matcher，共享已经读入的真值相机
+        Matcher matcher;
+        matcher.m_proj = base.m_proj;
+        matcher.m_image_sizes = base.m_image_sizes;
+        matcher.generateRandomPoints("", cam_num, config.max_points, box_size,
+                                     config.track_length, config.pixel_error, has_circle,
+                                     is_track_exp, seed);
+        ExportOptions config_options(export_options);
+        config_options.proj_matrices = matcher.m_proj;
+        std::unordered_map<int, std::string> config_names(cam_name);
+        ExtractToDatabase(cam_num, database_path, output_dir + "/match.txt", matcher.m_match_data,
+                          config_names, config_options);
+        seconds[k] = chrono::duration<double>(chrono::steady_clock::now() - config_start).count();
+    }
+    omp_set_max_active_levels(max_active_levels);
+    sqlite3_close(template_db);
+
+    for (int k = 0; k < configs.size(); ++k) {
+        printf("%s: %.2f 秒\n", configs[k].name.c_str(), seconds[k]);
+    }
+    cout << "参数扫描总耗时: "
+         << chrono::duration<double>(chrono::steady_clock::now() - sweep_start).count() << " 秒"
+         << endl;
+}
@@ -0,0 +1,9 @@
+#include "TrackStore.h"
+
+#include <iostream>
+
+void TrackStore::PrintStats(const char *name, double build_ms) const {
+    std::cout << name << ": " << NumTracks() << " 条轨迹, " << NumObservations() << " 个观测, "
+              << MemoryBytes() / 1048576.0 << " MB (稠密存储需 " << DenseMemoryBytes() / 1048576.0
+              << " MB), 构建耗时 " << build_ms << " ms" << std::endl;
+}
@@ -0,0 +1,255 @@
+#include "TwoViewGeometry.h"
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+Eigen::Matrix3d CrossMatrix(const Eigen::Vector3d &v) {
+    Eigen::Matrix3d m;
+    m << 0, -v(2), v(1),
+         v(2), 0, -v(0),
+         -v(1), v(0), 0;
+    return m;
+}
+
+// Hartley 归一化：平移到质心，缩放到平均距离 sqrt(2)
+Eigen::Matrix3d NormalizePoints(const std::vector<Eigen::Vector2d> &pts,
+                                const std::vector<int> &ids,
+                                std::vector<Eigen::Vector2d> &normalized) {
+    Eigen::Vector2d centroid(0, 0);
+    for (int id : ids) {
+        centroid += pts[id];
+    }
+    centroid /= ids.size();
+    double mean_dist(0.0);
+    for (int id : ids) {
+        mean_dist += (pts[id] - centroid).norm();
+    }
+    mean_dist /= ids.size();
+    double scale = mean_dist > 0 ? std::sqrt(2.0) / mean_dist : 1.0;
+    Eigen::Matrix3d T;
+    T << scale, 0, -scale * centroid(0),
+         0, scale, -scale * centroid(1),
+         0, 0, 1;
+    normalized.resize(ids.size());
+    for (int k = 0; k < ids.size(); ++k) {
+        normalized[k] = scale * (pts[ids[k]] - centroid);
+    }
+    return T;
+}
+
+// 归一化八点法（ids 至少 8 个），强制秩为 2
+bool EightPoint(const std::vector<Eigen::Vector2d> &pts1, const std::vector<Eigen::Vector2d> &pts2,
+                const std::vector<int> &ids, Eigen::Matrix3d &F) {
+    std::vector<Eigen::Vector2d> n1, n2;
+    Eigen::Matrix3d T1 = NormalizePoints(pts1, ids, n1);
+    Eigen::Matrix3d T2 = NormalizePoints(pts2, ids, n2);
+    Eigen::Matrix<double, Eigen::Dynamic, 9> A(ids.size(), 9);
+    for (int k = 0; k < ids.size(); ++k) {
+        double x1 = n1[k](0), y1 = n1[k](1), x2 = n2[k](0), y2 = n2[k](1);
+        A.row(k) << x2 * x1, x2 * y1, x2, y2 * x1, y2 * y1, y2, x1, y1, 1;
+    }
+    Eigen::JacobiSVD<Eigen::Matrix<double, Eigen::Dynamic, 9>> svd(A, Eigen::ComputeFullV);
+    Eigen::Matrix<double, 9, 1> f = svd.matrixV().col(8);
+    Eigen::Matrix3d F_norm;
+    F_norm << f(0), f(1), f(2),
+              f(3), f(4), f(5),
+              f(6), f(7), f(8);
+    Eigen::JacobiSVD<Eigen::Matrix3d> svd_f(F_norm, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    Eigen::Vector3d sigma = svd_f.singularValues();
+    sigma(2) = 0;
+    F_norm = svd_f.matrixU() * sigma.asDiagonal() * svd_f.matrixV().transpose();
+    F = T2.transpose() * F_norm * T1;
+    double norm = F.norm();
+    if (!(norm > 0)) {
+        return false;
+    }
+    F /= norm;
+    return true;
+}
+
+// Sampson 距离的平方
+double SampsonError(const Eigen::Matrix3d &F, const Eigen::Vector2d &p1, const Eigen::Vector2d &p2) {
+    Eigen::Vector3d x1(p1(0), p1(1), 1.0), x2(p2(0), p2(1), 1.0);
+    Eigen::Vector3d Fx1 = F * x1;
+    Eigen::Vector3d Ftx2 = F.transpose() * x2;
+    double x2tFx1 = x2.dot(Fx1);
+    double denom = Fx1(0) * Fx1(0) + Fx1(1) * Fx1(1) + Ftx2(0) * Ftx2(0) + Ftx2(1) * Ftx2(1);
+    return denom > 0 ? x2tFx1 * x2tFx1 / denom : 0.0;
+}
+
+int CountInliers(const std::vector<Eigen::Vector2d> &pts1, const std::vector<Eigen::Vector2d> &pts2,
+                 const Eigen::Matrix3d &F, double max_error2, std::vector<char> &mask) {
+    int num_inliers(0);
+    mask.resize(pts1.size());
+    for (int k = 0; k < pts1.size(); ++k) {
+        mask[k] = SampsonError(F, pts1[k], pts2[k]) <= max_error2;
+        num_inliers += mask[k];
+    }
+    return num_inliers;
+}
+
+}  // namespace
+
+Eigen::Matrix3d FundamentalFromProjections(const Matrix3x4d &P1, const Matrix3x4d &P2) {
+    // 相机 1 的光心为 P1 的右零空间
+    Eigen::JacobiSVD<Eigen::Matrix<double, 3, 4>> svd(P1, Eigen::ComputeFullV);
+    Eigen::Vector4d C1 = svd.matrixV().col(3);
+    Eigen::Vector3d e2 = P2 * C1; // 相机 2 中的极点
+    // P1 的伪逆
+    Eigen::Matrix<double, 4, 3> P1_pinv = P1.transpose() * (P1 * P1.transpose()).inverse();
+    Eigen::Matrix3d F = CrossMatrix(e2) * P2 * P1_pinv;
+    return F / F.norm();
+}
+
+Eigen::Matrix3d IntrinsicsFromProjection(const Matrix3x4d &P) {
+    // RQ 分解：对 (J * M)^T 做 QR，J 为反对角置换矩阵
+    Eigen::Matrix3d M = P.leftCols<3>();
+    Eigen::Matrix3d J;
+    J << 0, 0, 1,
+         0, 1, 0,
+         1, 0, 0;
+    Eigen::HouseholderQR<Eigen::Matrix3d> qr((J * M).transpose());
+    Eigen::Matrix3d R = qr.matrixQR().triangularView<Eigen::Upper>();
+    Eigen::Matrix3d K = J * R.transpose() * J;
+    // 调整符号使对角线为正
+    for (int i = 0; i < 3; ++i) {
+        if (K(i, i) < 0) {
+            K.col(i) = -K.col(i);
+        }
+    }
+    return K / K(2, 2);
+}
+
+Eigen::Matrix3d EssentialFromFundamental(const Eigen::Matrix3d &F, const Eigen::Matrix3d &K1,
+                                         const Eigen::Matrix3d &K2) {
+    Eigen::Matrix3d E = K2.transpose() * F * K1;
+    return E / E.norm();
+}
+
+int EstimateFundamentalRansac(const std::vector<Eigen::Vector2d> &pts1,
+                              const std::vector<Eigen::Vector2d> &pts2,
+                              const VerifyOptions &options, uint64_t seed, Eigen::Matrix3d &F,
+                              std::vector<char> &inlier_mask) {
+    int n = pts1.size();
+    inlier_mask.assign(n, 0);
+    if (n < 8) {
+        return 0;
+    }
+    double max_error2 = options.max_error * options.max_error;
+    std::mt19937_64 rng(seed);
+    std::vector<int> all_ids(n);
+    for (int k = 0; k < n; ++k) {
+        all_ids[k] = k;
+    }
+
+    // 1. RANSAC：随机取 8 对，保留内点最多的模型，并按内点率自适应减少迭代次数
+    int best_inliers(0);
+    Eigen::Matrix3d best_F = Eigen::Matrix3d::Zero();
+    std::vector<char> mask;
+    std::vector<int> sample(8);
+    int max_iterations = options.max_iterations;
+    for (int iter = 0; iter < max_iterations; ++iter) {
+        // 部分 Fisher-Yates 洗牌取不重复样本
+        for (int k = 0; k < 8; ++k) {
+            std::uniform_int_distribution<int> dist(k, n - 1);
+            std::swap(all_ids[k], all_ids[dist(rng)]);
+            sample[k] = all_ids[k];
+        }
+        Eigen::Matrix3d model;
+        if (!EightPoint(pts1, pts2, sample, model)) {
+            continue;
+        }
+        int num_inliers = CountInliers(pts1, pts2, model, max_error2, mask);
+        if (num_inliers > best_inliers) {
+            best_inliers = num_inliers;
+            best_F = model;
+            double inlier_ratio = double(num_inliers) / n;
+            double p_fail = 1.0 - std::pow(inlier_ratio, 8);
+            if (p_fail <= 0) {
+                break;
+            }
+            // 内点率很低时 p_fail 舍入为 1，所需次数为无穷大或极大，先在浮点数中截断再转 int
+            if (p_fail < 1) {
+                double needed = std::log(1.0 - options.confidence) / std::log(p_fail);
+                max_iterations = (int)std::min<double>(options.max_iterations, std::ceil(needed));
+            }
+        }
+    }
+    if (best_inliers < 8) {
+        return 0;
+    }
+
+    // 2. 用全部内点重新估计，再重新统计内点
+    CountInliers(pts1, pts2, best_F, max_error2, mask);
+    std::vector<int> inlier_ids;
+    for (int k = 0; k < n; ++k) {
+        if (mask[k]) {
+            inlier_ids.push_back(k);
+        }
+    }
+    Eigen::Matrix3d refined;
+    if (EightPoint(pts1, pts2, inlier_ids, refined) &&
+        CountInliers(pts1, pts2, refined, max_error2, mask) >= best_inliers) {
+        best_F = refined;
+    }
+    F = best_F;
+    return CountInliers(pts1, pts2, F, max_error2, inlier_mask);
+}
+
+bool CheckFundamentalRansac(const VerifyOptions &options, int num_points, double outlier_ratio,
+                            uint64_t seed) {
+    // 两个 1920x1080 相机，相机 2 绕 y 轴转 10 度、向右平移 1 米，三维点在前方 4 ~ 8 米
+    std::mt19937_64 rng(seed);
+    Eigen::Matrix3d K;
+    K << 1000, 0, 960,
+         0, 1000, 540,
+         0, 0, 1;
+    Matrix3x4d P1, P2;
+    P1 << K, Eigen::Vector3d::Zero();
+    Eigen::Matrix3d R;
+    double angle = 10.0 * M_PI / 180.0;
+    R << std::cos(angle), 0, std::sin(angle),
+         0, 1, 0,
+         -std::sin(angle), 0, std::cos(angle);
+    P2 << K * R, K * Eigen::Vector3d(-1, 0, 0);
+
+    std::uniform_real_distribution<double> lateral(-2, 2), depth(4, 8), pixel_u(0, 1920),
+        pixel_v(0, 1080), unit(0, 1);
+    std::normal_distribution<double> noise(0, 0.5);
+    std::vector<Eigen::Vector2d> pts1, pts2;
+    std::vector<char> is_inlier;
+    while (pts1.size() < num_points) {
+        Eigen::Vector4d X(lateral(rng), lateral(rng), depth(rng), 1);
+        Eigen::Vector3d x1 = P1 * X, x2 = P2 * X;
+        Eigen::Vector2d p1 = x1.hnormalized(), p2 = x2.hnormalized();
+        if (x2.z() <= 0 || p1.x() < 0 || p1.x() >= 1920 || p1.y() < 0 || p1.y() >= 1080 ||
+            p2.x() < 0 || p2.x() >= 1920 || p2.y() < 0 || p2.y() >= 1080) {
+            continue;
+        }
+        bool outlier = unit(rng) < outlier_ratio;
+        pts1.push_back(p1 + Eigen::Vector2d(noise(rng), noise(rng)));
+        pts2.push_back(outlier ? Eigen::Vector2d(pixel_u(rng), pixel_v(rng))
+                               : Eigen::Vector2d(p2 + Eigen::Vector2d(noise(rng), noise(rng))));
+        is_inlier.push_back(!outlier);
+    }
+
+    Eigen::Matrix3d F;
+    std::vector<char> mask;
+    int num_inliers = EstimateFundamentalRansac(pts1, pts2, options, seed, F, mask);
+    int num_true(0), num_recovered(0);
+    for (int k = 0; k < num_points; ++k) {
+        num_true += is_inlier[k];
+        num_recovered += is_inlier[k] && mask[k];
+    }
+    // 离群点偶尔也会落在阈值内，只要求真实内点基本都被找回
+    bool ok = num_recovered >= 0.95 * num_true;
+    printf("RANSAC 自检: %d 对, 离群比例 %.2f, 真实内点 %d, 找回 %d, 估计内点 %d%s\n",
+           num_points, outlier_ratio, num_true, num_recovered, num_inliers,
+           ok ? "" : " (失败)");
+    return ok;
+}
@@ -6,3 +6,66 @@ uint64_t ImageIdsToPairId(uint32_t id1, uint32_t id2) {
     }
     return 2147483647ll * id1 + id2;
 }
+
+namespace {
+
+int ReadBigEndian16(const unsigned char *p) {
+    return (p[0] << 8) | p[1];
+}
+
+int ReadBigEndian32(const unsigned char *p) {
+    return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+}  // namespace
+
+bool ReadImageSize(const std::string &path, int &width, int &height) {
+    std::ifstream fs(path, std::ios::binary);
+    if (!fs.is_open()) {
+        return false;
+    }
+    unsigned char header[24];
+    if (!fs.read(reinterpret_cast<char *>(header), sizeof(header))) {
+        return false;
+    }
+    // PNG：8 字节签名之后第一个块固定为 IHDR，宽高在 16~23 字节
+    static const unsigned char png_signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    if (memcmp(header, png_signature, sizeof(png_signature)) == 0 &&
+        memcmp(header + 12, "IHDR", 4) == 0) {
+        width = ReadBigEndian32(header + 16);
+        height = ReadBigEndian32(header + 20);
+        return width > 0 && height > 0;
+    }
+    // JPEG：逐段跳过，直到遇到 SOFn 段
+    if (header[0] != 0xff || header[1] != 0xd8) {
+        return false;
+    }
+    fs.seekg(2);
+    unsigned char segment[9];
+    while (fs.read(reinterpret_cast<char *>(segment), 4)) {
+        if (segment[0] != 0xff) {
+            return false;
+        }
+        int marker = segment[1];
+        if (marker == 0xff) {  // 填充字节
+            fs.seekg(-3, std::ios::cur);
+            continue;
+        }
+        int length = ReadBigEndian16(segment + 2);
+        // SOF0~SOF15，排除 DHT(C4)、JPG(C8)、DAC(CC)
+        if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 &&
+            marker != 0xcc) {
+            if (!fs.read(reinterpret_cast<char *>(segment + 4), 5)) {
+                return false;
+            }
+            height = ReadBigEndian16(segment + 5);
+            width = ReadBigEndian16(segment + 7);
+            return width > 0 && height > 0;
+        }
+        if (length < 2) {
+            return false;
+        }
+        fs.seekg(length - 2, std::ios::cur);
+    }
+    return false;
+}